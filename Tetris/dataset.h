@@ -0,0 +1,39 @@
+#ifndef TETRIS_DATASET_H__
+#define TETRIS_DATASET_H__
+
+#include <stdint.h>
+
+// 落子数据集格式：一个文件头后面紧跟若干定长记录，所有字段均为小端序。
+// 游戏端（定义 DATASET 编译）每锁定一个方块写出一条记录，
+// 主机端的 tools/dataset_reader 直接 mmap 文件按记录数组遍历。
+
+#define DATASET_MAGIC        0x53525454u  // "TTRS"
+#define DATASET_VERSION      1
+#define DATASET_RECORD_TAG   0xa5         // 每条记录的标记字节，用于识别流尾
+#define DATASET_ROWS         20
+#define DATASET_COLS         10
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint8_t  board_width;
+    uint8_t  board_height;
+    uint8_t  reserved[6];
+} __attribute__((packed)) dataset_header_t;
+
+typedef struct {
+    uint16_t rows[DATASET_ROWS];  // 落子前的棋盘，第 y 行第 x 位为 1 表示有方块
+    uint8_t  tag;                 // DATASET_RECORD_TAG
+    uint8_t  current;             // 当前方块形状 0~6 (I, O, T, L, J, S, Z)
+    uint8_t  next;                // 下一个方块形状
+    uint8_t  rotation;            // 落点：旋转状态
+    int8_t   x, y;                // 落点：4x4 形状框左上角在棋盘上的坐标
+    uint8_t  lines;               // 这次落子消除的行数
+    uint8_t  reserved;
+} __attribute__((packed)) dataset_record_t;
+
+_Static_assert(sizeof(dataset_header_t) == 16, "dataset header must be 16 bytes");
+_Static_assert(sizeof(dataset_record_t) == 48, "dataset record must be 48 bytes");
+
+#endif
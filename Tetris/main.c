@@ -3,11 +3,18 @@
 #include <am.h>
 #include <amdev.h>
 #include <klib-macros.h>
+#ifdef DATASET
+#include "dataset.h"
+#endif
 
-#define TILE_W 10
 #define BOARD_WIDTH 10
 #define BOARD_HEIGHT 20
 #define NEXT_PIECE_SIZE 4
+// 整个界面占用的格子数：主面板加边框，预览区加边框和间隔
+#define LAYOUT_TILES_X (BOARD_WIDTH + NEXT_PIECE_SIZE + 5)
+#define LAYOUT_TILES_Y (BOARD_HEIGHT + 2)
+#define CLEAR_FLASH_US 60000   // 消行闪烁每个相位的时长(微秒)
+#define CLEAR_FLASH_STEPS 4    // 闪烁相位数，亮暗交替，结束后满行才被移除
 
 // 方块形状定义 (I, O, T, L, J, S, Z)
 static const int shapes[7][4][4][4] = {
@@ -63,7 +70,7 @@ static const int shapes[7][4][4][4] = {
 };
 
 // 方块颜色
-static const uint32_t colors[8] = {
+static const uint32_t colors[9] = {
     0x00000000,   // 空白
     0x0000ffff,   // I - 青色
     0x00ffff00,   // O - 黄色
@@ -71,8 +78,13 @@ static const uint32_t colors[8] = {
     0x00ff8000,   // L - 橙色
     0x000000ff,   // J - 蓝色
     0x0000ff00,   // S - 绿色
-    0x00ff0000    // Z - 红色
+    0x00ff0000,   // Z - 红色
+    0x00ffffff    // 边框 - 白色
 };
+#define COLOR_BORDER 8
+
+static int tile_w;                              // 每格像素大小（由屏幕分辨率决定）
+static uint32_t *tile_sprites[LENGTH(colors)];  // 按 tile_w 预渲染的各色方块
 
 typedef struct {
     int x, y;
@@ -80,6 +92,16 @@ typedef struct {
     int rotation;
 } piece_t;
 
+// 消行动画：满行先在原位闪烁，由主循环按时间推进，不阻塞输入和下落
+typedef struct {
+    int active;
+    int rows[4];        // 待消除的行号（从上到下）
+    int count;
+    uint32_t mask;      // 待消除行的位图，第 y 位对应第 y 行
+    int phase;          // 已绘制的闪烁相位，-1 表示还未绘制
+    uint64_t start;
+} clear_anim_t;
+
 typedef struct {
     int board[BOARD_HEIGHT][BOARD_WIDTH];
     piece_t current;
@@ -87,18 +109,31 @@ typedef struct {
     int score;
     int game_over;
     piece_t last_next;                    
+    clear_anim_t clearing;
 } game_t;
 
 static void refresh() {
     io_write(AM_GPU_FBDRAW, 0, 0, NULL, 0, 0, true);
 }
 
-static void draw_tile(int y, int x, uint32_t color) {
-    static uint32_t buf[TILE_W * TILE_W];
-    for (int i = 0; i < LENGTH(buf); i++) {
-        buf[i] = color;
+// 根据屏幕大小确定格子尺寸，并为每种颜色预渲染一块贴图
+static void init_tiles(int screen_width, int screen_height) {
+    int w = screen_width / LAYOUT_TILES_X;
+    int h = screen_height / LAYOUT_TILES_Y;
+    tile_w = w < h ? w : h;
+    if (tile_w < 1) tile_w = 1;
+
+    for (int i = 0; i < LENGTH(colors); i++) {
+        tile_sprites[i] = malloc(tile_w * tile_w * sizeof(uint32_t));
+        panic_on(!tile_sprites[i], "Memory allocation failed for tile sprites");
+        for (int j = 0; j < tile_w * tile_w; j++) {
+            tile_sprites[i][j] = colors[i];
+        }
     }
-    io_write(AM_GPU_FBDRAW, x * TILE_W, y * TILE_W, buf, TILE_W, TILE_W, false);
+}
+
+static void draw_tile(int y, int x, int color_idx) {
+    io_write(AM_GPU_FBDRAW, x * tile_w, y * tile_w, tile_sprites[color_idx], tile_w, tile_w, false);
 }
 
 static int read_key() {
@@ -116,6 +151,8 @@ static void init_game(game_t *game) {
     srand(io_read(AM_TIMER_UPTIME).us);
     game->score = 0;
     game->game_over = 0;
+    game->clearing.active = 0;
+    game->clearing.mask = 0;
     game->current.shape = rand() % 7;
     game->current.rotation = 0;
     game->current.x = BOARD_WIDTH / 2 - 2;
@@ -153,13 +190,121 @@ static void clear_next_piece(piece_t *piece, int offset_x, int offset_y) {
             if (piece->shape != -1 && shapes[piece->shape][piece->rotation][y][x]) {
                 int draw_x = offset_x + x;
                 int draw_y = offset_y + y;
-                draw_tile(draw_y, draw_x, colors[0]); 
+                draw_tile(draw_y, draw_x, 0);
             }
         }
     }
 }
 
+#ifdef DATASET
+// 落子数据集输出：native 下若设置了 TETRIS_DATASET 环境变量则写入该文件，
+// 否则逐字节写到串口，由主机端重定向保存
+#ifdef __ISA_NATIVE__
+static FILE *dataset_fp = NULL;
+#endif
+
+static void dataset_write(const void *data, int len) {
+#ifdef __ISA_NATIVE__
+    if (dataset_fp) {
+        fwrite(data, 1, len, dataset_fp);
+        return;
+    }
+#endif
+    const uint8_t *p = data;
+    for (int i = 0; i < len; i++) {
+        putch(p[i]);
+    }
+}
+
+static void dataset_begin() {
+#ifdef __ISA_NATIVE__
+    const char *path = getenv("TETRIS_DATASET");
+    if (path) dataset_fp = fopen(path, "wb");
+#endif
+    dataset_header_t hdr = {
+        .magic = DATASET_MAGIC,
+        .version = DATASET_VERSION,
+        .record_size = sizeof(dataset_record_t),
+        .board_width = BOARD_WIDTH,
+        .board_height = BOARD_HEIGHT,
+    };
+    dataset_write(&hdr, sizeof(hdr));
+}
+
+static void dataset_end() {
+#ifdef __ISA_NATIVE__
+    if (dataset_fp) fclose(dataset_fp);
+    dataset_fp = NULL;
+#endif
+}
+
+// 记录锁定前的棋盘，落点和消行数在锁定后补上
+static void dataset_snapshot(game_t *game, dataset_record_t *rec) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        uint16_t bits = 0;
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            if (game->board[y][x]) bits |= 1u << x;
+        }
+        rec->rows[y] = bits;
+    }
+    rec->tag = DATASET_RECORD_TAG;
+    rec->current = game->current.shape;
+    rec->next = game->next.shape;
+    rec->rotation = game->current.rotation;
+    rec->x = game->current.x;
+    rec->y = game->current.y;
+    rec->lines = 0;
+    rec->reserved = 0;
+}
+#endif
+
+// 真正移除满行：按从上到下的顺序删除，上方的行整体下移
+static void collapse_rows(game_t *game) {
+    clear_anim_t *c = &game->clearing;
+    for (int i = 0; i < c->count; i++) {
+        for (int yy = c->rows[i]; yy > 0; yy--) {
+            for (int x = 0; x < BOARD_WIDTH; x++) {
+                game->board[yy][x] = game->board[yy - 1][x];
+            }
+        }
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            game->board[0][x] = 0;
+        }
+    }
+    c->active = 0;
+    c->mask = 0;
+}
+
+// 结束消行动画。动画期间下落中的方块跟随其下方的棋盘一起下移，
+// 它占据的行是连续的且不可能是满行，所以下移的行数对每个格子都相同
+static void finish_line_clear(game_t *game) {
+    clear_anim_t *c = &game->clearing;
+    piece_t *p = &game->current;
+    int bottom = -1;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            if (shapes[p->shape][p->rotation][y][x]) bottom = p->y + y;
+        }
+    }
+    for (int i = 0; i < c->count; i++) {
+        if (c->rows[i] > bottom) p->y++;
+    }
+    collapse_rows(game);
+}
+
 static void lock_piece(game_t *game) {
+    // 上一次消行动画还没播完就又落地了：先完成消行，方块若因此悬空则继续下落
+    if (game->clearing.active) {
+        finish_line_clear(game);
+        piece_t below = game->current;
+        below.y++;
+        if (!check_collision(game, &below)) return;
+    }
+
+#ifdef DATASET
+    dataset_record_t rec;
+    dataset_snapshot(game, &rec);
+#endif
     for (int y = 0; y < 4; y++) {
         for (int x = 0; x < 4; x++) {
             if (shapes[game->current.shape][game->current.rotation][y][x]) {
@@ -176,8 +321,11 @@ static void lock_piece(game_t *game) {
         }
     }
 
-    int lines_cleared = 0;
-    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
+    // 只记录满行，实际移除交给消行动画结束时完成
+    clear_anim_t *c = &game->clearing;
+    c->count = 0;
+    c->mask = 0;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
         int full = 1;
         for (int x = 0; x < BOARD_WIDTH; x++) {
             if (game->board[y][x] == 0) {
@@ -187,18 +335,20 @@ static void lock_piece(game_t *game) {
         }
         
         if (full) {
-            lines_cleared++;
-            for (int yy = y; yy > 0; yy--) {
-                for (int x = 0; x < BOARD_WIDTH; x++) {
-                    game->board[yy][x] = game->board[yy - 1][x];
-                }
-            }
-            for (int x = 0; x < BOARD_WIDTH; x++) {
-                game->board[0][x] = 0;
-            }
-            y++;
+            c->rows[c->count++] = y;
+            c->mask |= 1u << y;
         }
     }
+    int lines_cleared = c->count;
+#ifdef DATASET
+    rec.lines = lines_cleared;
+    dataset_write(&rec, sizeof(rec));
+#endif
+    if (lines_cleared > 0) {
+        c->active = 1;
+        c->phase = -1;
+        c->start = io_read(AM_TIMER_UPTIME).us;
+    }
     
 
     if (lines_cleared == 1) game->score += 100;
@@ -214,14 +364,39 @@ static void lock_piece(game_t *game) {
     
     game->next.shape = rand() % 7;
     game->next.rotation = 0;
+    // 新方块还没进入棋盘，出生点被挡住时先完成消行再判断是否结束
+    if (check_collision(game, &game->current) && game->clearing.active) {
+        collapse_rows(game);
+    }
     if (check_collision(game, &game->current)) {
         game->game_over = 1;
     }
 }
 
+// 推进消行动画：只在相位变化时重绘被消除的那几行
+static void update_line_clear(game_t *game, int offset_x, int offset_y) {
+    clear_anim_t *c = &game->clearing;
+    if (!c->active) return;
+
+    int phase = (io_read(AM_TIMER_UPTIME).us - c->start) / CLEAR_FLASH_US;
+    if (phase >= CLEAR_FLASH_STEPS) {
+        finish_line_clear(game);
+        return;
+    }
+    if (phase == c->phase) return;
+    c->phase = phase;
+
+    int color_idx = (phase % 2 == 0) ? COLOR_BORDER : 0;
+    for (int i = 0; i < c->count; i++) {
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            draw_tile(offset_y + c->rows[i], offset_x + x, color_idx);
+        }
+    }
+}
+
 
 static void draw_game(game_t *game, int offset_x, int offset_y) {
-    uint32_t border_color = 0x00ffffff;
+    int border_color = COLOR_BORDER;
     for (int x = -1; x <= BOARD_WIDTH; x++) {
         draw_tile(offset_y - 1, offset_x + x, border_color);
         draw_tile(offset_y + BOARD_HEIGHT, offset_x + x, border_color);
@@ -231,9 +406,10 @@ static void draw_game(game_t *game, int offset_x, int offset_y) {
         draw_tile(offset_y + y, offset_x + BOARD_WIDTH, border_color);
     }
     for (int y = 0; y < BOARD_HEIGHT; y++) {
+        if (game->clearing.mask & (1u << y)) continue;  // 正在闪烁的行由消行动画负责绘制
         for (int x = 0; x < BOARD_WIDTH; x++) {
             int color_idx = game->board[y][x];
-            draw_tile(offset_y + y, offset_x + x, colors[color_idx]);
+            draw_tile(offset_y + y, offset_x + x, color_idx);
         }
     }
     
@@ -244,7 +420,7 @@ static void draw_game(game_t *game, int offset_x, int offset_y) {
                 int draw_x = offset_x + p->x + x;
                 int draw_y = offset_y + p->y + y;
                 if (p->y + y >= 0) {
-                    draw_tile(draw_y, draw_x, colors[p->shape + 1]);
+                    draw_tile(draw_y, draw_x, p->shape + 1);
                 }
             }
         }
@@ -260,10 +436,11 @@ static void draw_game(game_t *game, int offset_x, int offset_y) {
         draw_tile(next_offset_y + y, next_offset_x - 1, border_color);
         draw_tile(next_offset_y + y, next_offset_x + NEXT_PIECE_SIZE, border_color);
     }
-    draw_tile(next_offset_y - 3, next_offset_x, 0x00ffff00);
-    draw_tile(next_offset_y - 3, next_offset_x + 1, 0x00ffff00);
-    draw_tile(next_offset_y - 3, next_offset_x + 2, 0x00ffff00);
-    draw_tile(next_offset_y - 3, next_offset_x + 3, 0x00ffff00);
+    // 预览区上方的黄色标题条（与 O 方块同色）
+    draw_tile(next_offset_y - 3, next_offset_x, 2);
+    draw_tile(next_offset_y - 3, next_offset_x + 1, 2);
+    draw_tile(next_offset_y - 3, next_offset_x + 2, 2);
+    draw_tile(next_offset_y - 3, next_offset_x + 3, 2);
     
     clear_next_piece(&game->last_next, next_offset_x, next_offset_y);
     p = &game->next;
@@ -272,26 +449,27 @@ static void draw_game(game_t *game, int offset_x, int offset_y) {
             if (shapes[p->shape][p->rotation][y][x]) {
                 int draw_x = next_offset_x + x;
                 int draw_y = next_offset_y + y;
-                draw_tile(draw_y, draw_x, colors[p->shape + 1]);
+                draw_tile(draw_y, draw_x, p->shape + 1);
             }
         }
     }
     for (int i = 0; i < 4; i++) {
-        draw_tile(next_offset_y + NEXT_PIECE_SIZE + 5, next_offset_x + i, colors[0]);
+        draw_tile(next_offset_y + NEXT_PIECE_SIZE + 5, next_offset_x + i, 0);
     }
     
     int score_offset_y = next_offset_y + NEXT_PIECE_SIZE + 3;
-    draw_tile(score_offset_y, next_offset_x, 0x00ff0000);
-    draw_tile(score_offset_y, next_offset_x + 1, 0x00ff0000);
-    draw_tile(score_offset_y, next_offset_x + 2, 0x00ff0000);
-    draw_tile(score_offset_y, next_offset_x + 3, 0x00ff0000);
+    // 红色分数标题条（与 Z 方块同色）
+    draw_tile(score_offset_y, next_offset_x, 7);
+    draw_tile(score_offset_y, next_offset_x + 1, 7);
+    draw_tile(score_offset_y, next_offset_x + 2, 7);
+    draw_tile(score_offset_y, next_offset_x + 3, 7);
     
     int score = game->score;
     for (int i = 0; i < 4; i++) {
         int digit = score % 10;
         score /= 10;
         if (digit > 0) {
-            draw_tile(score_offset_y + 2, next_offset_x + 3 - i, 0x0000ffff);
+            draw_tile(score_offset_y + 2, next_offset_x + 3 - i, 1);
         }
     }
 }
@@ -303,18 +481,25 @@ int main() {
     uint64_t last_fall = 0;
     
     ioe_init();
-    const int screen_width = 400;
-    const int screen_height = 300;
+    AM_GPU_CONFIG_T gpu_cfg = io_read(AM_GPU_CONFIG);
+    const int screen_width = gpu_cfg.width;
+    const int screen_height = gpu_cfg.height;
+    init_tiles(screen_width, screen_height);
     
-    const int max_tiles_x = screen_width / TILE_W; 
-    const int max_tiles_y = screen_height / TILE_W;
+    const int max_tiles_x = screen_width / tile_w; 
+    const int max_tiles_y = screen_height / tile_w;
     
-    int offset_x = (max_tiles_x - BOARD_WIDTH - 8) / 2;  
-    int offset_y = (max_tiles_y - BOARD_HEIGHT) / 2;     
+    // 偏移量指向主面板左上角，边框在其外侧一格
+    int offset_x = (max_tiles_x - LAYOUT_TILES_X) / 2 + 1;  
+    int offset_y = (max_tiles_y - LAYOUT_TILES_Y) / 2 + 1;     
     
     init_game(&game);
+#ifdef DATASET
+    dataset_begin();
+#endif
     
     while (!game.game_over) {
+        update_line_clear(&game, offset_x, offset_y);
         draw_game(&game, offset_x, offset_y);
         refresh();
         
@@ -369,6 +554,9 @@ int main() {
         fall_delay = 1000000 - (game.score / 1000) * 100000;
         if (fall_delay < 100000) fall_delay = 100000;
     }
+#ifdef DATASET
+    dataset_end();
+#endif
     printf("GAME OVER! Score: %d\nPress Q to Exit\n", game.score);
     while (read_key() != AM_KEY_Q);
     
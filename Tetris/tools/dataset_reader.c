@@ -0,0 +1,91 @@
+// 主机端落子数据集读取工具
+// 用法: dataset_reader <file> [-d 记录号]
+// 直接 mmap 数据文件，把文件头之后的内容当作 dataset_record_t 数组遍历，不做任何拷贝。
+// 串口采集的文件尾部可能混有游戏打印的文字，遇到标记字节不对的记录即视为数据结束。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../dataset.h"
+
+static const char shape_names[7] = { 'I', 'O', 'T', 'L', 'J', 'S', 'Z' };
+
+static void dump_record(const dataset_record_t *r, size_t idx, int width, int height) {
+    printf("record %zu: piece %c next %c rotation %d at (%d, %d), %d line(s)\n",
+           idx, shape_names[r->current % 7], shape_names[r->next % 7],
+           r->rotation, r->x, r->y, r->lines);
+    for (int y = 0; y < height; y++) {
+        putchar('|');
+        for (int x = 0; x < width; x++) {
+            putchar((r->rows[y] >> x) & 1 ? '#' : '.');
+        }
+        puts("|");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file> [-d index]\n", argv[0]);
+        return 1;
+    }
+    long dump_idx = -1;
+    if (argc >= 4 && strcmp(argv[2], "-d") == 0) dump_idx = atol(argv[3]);
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(dataset_header_t)) {
+        fprintf(stderr, "%s: file too small\n", argv[1]);
+        return 1;
+    }
+    const uint8_t *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    close(fd);
+
+    const dataset_header_t *hdr = (const dataset_header_t *)base;
+    if (hdr->magic != DATASET_MAGIC || hdr->version != DATASET_VERSION ||
+        hdr->record_size != sizeof(dataset_record_t) ||
+        hdr->board_width > DATASET_COLS || hdr->board_height > DATASET_ROWS) {
+        fprintf(stderr, "%s: not a Tetris dataset (or unsupported version)\n", argv[1]);
+        return 1;
+    }
+
+    const dataset_record_t *recs = (const dataset_record_t *)(base + sizeof(*hdr));
+    size_t max = (st.st_size - sizeof(*hdr)) / sizeof(dataset_record_t);
+    size_t n = 0;
+    while (n < max && recs[n].tag == DATASET_RECORD_TAG) n++;
+
+    size_t lines[5] = {0}, pieces[7] = {0}, filled = 0;
+    for (size_t i = 0; i < n; i++) {
+        const dataset_record_t *r = &recs[i];
+        lines[r->lines > 4 ? 4 : r->lines]++;
+        pieces[r->current % 7]++;
+        for (int y = 0; y < hdr->board_height; y++) {
+            filled += __builtin_popcount(r->rows[y]);
+        }
+    }
+
+    printf("%zu positions (%dx%d board)\n", n, hdr->board_width, hdr->board_height);
+    printf("lines cleared: 0:%zu 1:%zu 2:%zu 3:%zu 4:%zu\n",
+           lines[0], lines[1], lines[2], lines[3], lines[4]);
+    printf("pieces:");
+    for (int i = 0; i < 7; i++) printf(" %c:%zu", shape_names[i], pieces[i]);
+    printf("\n");
+    if (n > 0) printf("average filled cells: %.2f\n", (double)filled / n);
+
+    if (dump_idx >= 0 && (size_t)dump_idx < n) {
+        dump_record(&recs[dump_idx], dump_idx, hdr->board_width, hdr->board_height);
+    }
+
+    munmap((void *)base, st.st_size);
+    return 0;
+}
@@ -5,23 +5,36 @@
 #include <amdev.h>
 #include <klib-macros.h>
 #include <time.h>
-
-// 为了避免浮点数运算，使用整数缩放因子
-#define SCALE 100  // 缩放比例，相当于小数点后两位
-
-// 游戏常量定义
-#define FPS 90             // 帧率
-#define FRAME_DELAY (1000000 / FPS)  // 每帧延迟(微秒)
-
-// 游戏元素尺寸（比例定义，使用整数计算）
-#define BIRD_SIZE_RATIO 7    // 小鸟大小占屏幕高度比例 * 100
-#define PIPE_WIDTH_RATIO 12  // 管道宽度占屏幕宽度比例 * 100
-#define PIPE_GAP_RATIO 35    // 管道间隙占屏幕高度比例 * 100
-#define PIPE_SPEED_RATIO 5   // 管道速度占屏幕宽度比例 * 1000
-#define GRAVITY 50           // 重力加速度 * SCALE (原0.5)
-#define JUMP_FORCE -800      // 跳跃力度 * SCALE 
-#define GROUND_HEIGHT_RATIO 5 // 地面高度占屏幕高度比例 * 100
+#include "physics.h"
+#include "fill.h"
+
+// 游戏循环参数
+#define MAX_CATCHUP_TICKS 8  // 一次最多追赶的物理步数，落后更多时整体放慢而不是卡死
+#define MAX_FRAME_SKIP 4     // 落后时最多连续跳过的渲染帧数
+
+// 每个物理步推进 PHYSICS_DIV 个基础步（physics.h 中按 FPS 调校的步长）。慢速主机上可设为2、3
+// 降低物理频率：位置按基础步的公式一次算出，碰撞沿路径扫掠，游戏结果与逐个基础步推进相同
+#ifndef PHYSICS_DIV
+#define PHYSICS_DIV 1
+#endif
+#define STEP_US (TICK_US * PHYSICS_DIV)  // 物理步长(微秒)
+
+// 内部渲染分辨率为屏幕的 1/2^RENDER_SHIFT（0、1、2），上传时按最近邻放大到整屏。
+// 游戏逻辑和脏矩形都用屏幕坐标，只在绘制和上传时换算到缓冲区坐标
+#ifndef RENDER_SHIFT
+#define RENDER_SHIFT 0
+#endif
+#define RENDER_SCALE (1 << RENDER_SHIFT)
+#define TO_FB(v) ((v) >> RENDER_SHIFT)                               // 起点，向下取整
+#define TO_FB_END(v) (((v) + RENDER_SCALE - 1) >> RENDER_SHIFT)      // 终点，向上取整
+#define FB_LEN(v) (TO_FB(v) > 0 ? TO_FB(v) : 1)                      // 图案尺寸，至少1像素
+
+// 游戏元素尺寸（小鸟、管道等见 physics.h）
 #define COIN_SIZE_RATIO 3    // 金币大小占屏幕高度比例 * 100
+#define MAX_DIRTY 32         // 每帧最多记录的脏矩形数，超出则整屏上传
+#define CLOUD_TOP_RATIO 8    // 云层顶端位置占屏幕高度比例 * 100
+#define CLOUD_HEIGHT_RATIO 22 // 云层高度占屏幕高度比例 * 100
+#define SKYLINE_HEIGHT_RATIO 20 // 远景楼群高度占屏幕高度比例 * 100
 
 // 颜色定义
 #define COLOR_BG      0x0087CEEB  // 背景天空蓝
@@ -34,6 +47,27 @@
 #define COLOR_COIN    0x00FFD700  // 金币金色
 #define COLOR_COIN_BORDER 0x00FFA500 // 金币边框橙色
 #define COLOR_SCORE   0x00FFD700  // 分数黄色
+#define COLOR_CLOUD   0x00F5FAFF  // 云朵白色
+#define COLOR_CLOUD_SHADE 0x00DCEBF5 // 云朵底部阴影
+#define COLOR_SKYLINE 0x0073AFC8  // 远景楼群灰蓝
+#define COLOR_WINDOW  0x009CCFE3  // 远景楼群窗户
+#define COLOR_WING    0x00F0A818  // 小鸟翅膀
+#define COLOR_BEAK    0x00FF7F27  // 小鸟嘴
+#define COLOR_EYE     0x00FFFFFF  // 小鸟眼白
+#define COLOR_PUPIL   0x00000000  // 小鸟瞳孔
+#define COLOR_NONE    0xFFFFFFFFu // 精灵中的透明像素（只在生成时使用）
+
+// 实体池容量（都是2的幂，环形下标用掩码回绕）
+#define MAX_PIPES 8
+#define MAX_COINS 16
+
+// 粒子：所有粒子寿命相同，按生成顺序存放在环形池中，过期的总在队头
+#define MAX_PARTICLES 4096   // 粒子池容量（2的幂），满了覆盖最旧的粒子
+#define PARTICLE_TICKS 45    // 粒子寿命（物理步）
+#define PARTICLE_GRAVITY 25  // 粒子重力 * SCALE
+#define PARTICLE_SIZES 3     // 粒子随年龄缩小的级数，第k级半径为 PARTICLE_SIZES-1-k 像素
+#define COIN_BURST 24        // 吃到金币时迸出的粒子数
+#define CRASH_BURST 64       // 撞毁时迸出的羽毛数
 
 // 游戏状态枚举
 typedef enum {
@@ -41,28 +75,45 @@ typedef enum {
     GAME_OVER
 } GameState;
 
+// 屏幕矩形区域
+typedef struct {
+    int x, y, w, h;
+} Rect;
+
+// 绘制时的裁剪带：缓冲区中 [y0, y1) 行，多核渲染时每个核负责一条
+typedef struct {
+    int y0, y1;
+} Band;
+
 // 管道结构体
 typedef struct {
     int x;          // 管道x坐标
+    int prev_x;     // 上一物理步的x坐标（渲染插值用）
     int gap_y;      // 管道间隙y坐标（中心）
-    bool passed;    // 是否已穿过（用于计分）
-    bool active;    // 管道是否处于活动状态
+    bool drawn;     // 上一帧是否已画在屏幕上
+    int drawn_x;    // 上一帧绘制时的x坐标
 } Pipe;
 
-// 金币结构体
+// 金币池（结构数组）：活动金币紧凑存放在前 count 个位置，
+// 收集或离开屏幕时把最后一个搬过来填补空位，不需要活动标记也不需要找空位
 typedef struct {
-    int x;          // 金币x坐标
-    int y;          // 金币y坐标
-    int size;       // 金币大小
-    bool collected; // 是否已收集
-    bool active;    // 是否活动
-} Coin;
+    int x[MAX_COINS];       // 金币x坐标
+    int prev_x[MAX_COINS];  // 上一物理步的x坐标（渲染插值用）
+    int y[MAX_COINS];       // 金币y坐标
+    bool drawn[MAX_COINS];  // 上一帧是否已画在屏幕上
+    int drawn_x[MAX_COINS]; // 上一帧绘制时的坐标
+    int drawn_y[MAX_COINS];
+    int count;              // 活动金币数量
+} CoinPool;
 
 // 游戏全局状态
 static struct {
     // 屏幕尺寸（动态获取）
     int screen_width;
     int screen_height;
+    // 缓冲区尺寸（屏幕尺寸按 RENDER_SHIFT 缩小）
+    int fb_width;
+    int fb_height;
     // 元素实际尺寸（根据屏幕计算）
     int bird_size;
     int pipe_width;
@@ -73,24 +124,116 @@ static struct {
     // 小鸟状态（使用整数模拟浮点运算）
     int bird_y;     // 小鸟y坐标 * SCALE
     int velocity;   // 小鸟竖直速度 * SCALE
-    // 管道状态
-    Pipe pipes[5];  // 最多同时存在5个管道
-    int active_pipes; // 当前活动管道数量
+    int prev_bird_y; // 上一物理步的小鸟y坐标 * SCALE
+    // 管道状态：管道总是从右侧生成、从左侧离开，按生成顺序放在环形队列里，
+    // 队首是最左边的管道。pipe_ahead 之前的管道小鸟都已穿过
+    Pipe pipes[MAX_PIPES];
+    int pipe_head;  // 队首（最早生成的管道）下标
+    int pipe_count; // 活动管道数量
+    int pipe_ahead; // 小鸟前方第一个管道在队列中的序号（0 ~ pipe_count）
     // 金币状态
-    Coin coins[10]; // 最多同时存在10个金币
-    int active_coins; // 当前活动金币数量
+    CoinPool coins;
     // 游戏信息
     int score;      // 分数
     int coin_score; // 金币额外分数
     GameState state;// 游戏状态
-    // 地面滚动
-    int ground_offset;
+    // 渲染插值系数（0~SCALE）：渲染时刻位于上一物理步和当前物理步之间的位置
+    int alpha;
     // 缓冲区
     uint32_t *frame_buf; // 全屏缓冲区
+    // 脏矩形：本帧需要上传到屏幕的区域
+    Rect dirty[MAX_DIRTY];
+    int dirty_count;
+    bool full_redraw;    // 本帧需要整屏上传（重置、状态切换等）
+    bool bird_drawn;     // 上一帧小鸟的绘制位置
+    int drawn_bird_y;
+    int drawn_score;     // 上一帧显示的分数
+    int drawn_coin_score;
+    bool game_over_drawn; // 游戏结束画面已合成并上传
 } game;
 
 // 预分配字符缓冲区（更大的字符尺寸，16x16像素，使字体更圆滑）
 static uint32_t *char_buf = NULL;   // 字符绘制缓冲区
+#if RENDER_SHIFT > 0
+static uint32_t *scale_buf = NULL;  // 放大上传用的行缓冲
+#endif
+
+// 圆形的逐行跨度表：第i行（y = 圆心y + top + i）覆盖 [x0[i], x1[i])，x相对圆心
+typedef struct {
+    int top;
+    int rows;
+    int16_t *x0, *x1;
+} Spans;
+
+// 按当前尺寸预先算好的圆形（init_game时生成）
+static Spans coin_outer_spans;  // 金币外圈（边框色）
+static Spans coin_inner_spans;  // 金币内部（金色）
+static Spans coin_icon_spans;   // 分数旁的小金币图标
+
+// 视差背景层：启动时画好的一条与屏幕等宽、首尾相接的横带，
+// 每帧按滚动偏移分两段整行拷贝到缓冲区，不再逐像素生成
+typedef struct {
+    uint32_t *pix;      // h 行，每行 fb_width 个像素
+    int y, h;           // 在缓冲区中的纵向位置
+    int speed;          // 每个物理步滚动的屏幕距离 * SCALE（越远越慢）
+    int pos, prev_pos;  // 本步和上一步的滚动位置（屏幕像素 * SCALE），屏幕x处显示横带的 TO_FB(x + pos) 列
+    int drawn_offset;   // 上一帧绘制时的偏移，-1 表示未绘制
+} Layer;
+
+enum { LAYER_CLOUDS, LAYER_SKYLINE, LAYER_GROUND, NR_LAYERS };
+static Layer layers[NR_LAYERS];
+
+// 行程编码的精灵：每行若干段同色像素，段之间是透明的
+typedef struct {
+    int16_t x, len;     // 相对中心的起点和长度
+    uint32_t color;
+} Run;
+
+typedef struct {
+    int top, rows;      // 第i行 y = 中心y + top + i
+    int *row_start;     // 第i行的段为 runs[row_start[i] .. row_start[i+1])
+    Run *runs;
+} Sprite;
+
+static Sprite bird_sprites[BIRD_ANGLES];  // 各个倾斜角度的小鸟（缓冲区分辨率）
+static int bird_sprite_r;                 // 小鸟精灵覆盖的半边长（屏幕坐标，脏矩形用）
+
+// 1位碰撞掩码（屏幕分辨率，与物理坐标一致）：每行打包成若干32位字，
+// 第k个字的第j位对应 x = 中心x + left + 32k + j
+typedef struct {
+    int left, top, w, h;    // 相对中心的左上角和尺寸
+    int words;              // 每行的字数
+    int x0, y0, x1, y1;     // 不透明像素的包围盒（相对中心，左闭右开）
+    uint32_t *bits;
+} Mask;
+
+static Mask bird_masks[BIRD_ANGLES];  // 与 bird_sprites 一一对应
+static Mask coin_mask;
+
+// 粒子池（结构数组，静态分配，生成效果时不再分配内存）
+static struct {
+    int32_t x[MAX_PARTICLES], y[MAX_PARTICLES];    // 位置 * SCALE
+    int32_t vx[MAX_PARTICLES], vy[MAX_PARTICLES];  // 每步速度 * SCALE
+    uint32_t color[MAX_PARTICLES];
+    uint32_t born[MAX_PARTICLES];  // 生成时的物理步编号
+    int head, count;
+    uint32_t tick;                 // 物理步计数
+    uint32_t seed;
+} particles;
+
+static Spans particle_spans[PARTICLE_SIZES];  // 各级粒子的圆点（缓冲区分辨率）
+static bool particles_drawn;                  // 上一帧粒子覆盖的区域
+static Rect drawn_particles;
+
+#if defined(SPAN_RENDER) || defined(BENCH)
+// 扫描线渲染用：每帧渲染前把粒子按首行分桶（各条带只读）
+static struct {
+    int16_t x[MAX_PARTICLES], top[MAX_PARTICLES];  // 圆点中心x和首行y（缓冲区坐标），按池中下标
+    uint8_t size[MAX_PARTICLES];
+    int16_t order[MAX_PARTICLES];  // 分桶后的粒子，存生成先后序号（越大越新），每桶内新的在前
+    int *bucket;                   // 首行为 y 的粒子是 order[bucket[y] .. bucket[y+1])
+} span_particles;
+#endif
 
 // 微秒级延迟函数
 static void delay_us(unsigned int us) {
@@ -105,18 +248,333 @@ static int mul_scale(int a, int b, int scale) {
     return (a * b) / scale;
 }
 
+// 生成圆形跨度表：在 [lo, hi] 的方形范围内满足 dx*dx + dy*dy <= r2 的点
+static void build_spans(Spans *s, int lo, int hi, int r2) {
+    s->top = lo;
+    s->rows = hi - lo + 1;
+    s->x0 = (int16_t*)malloc(s->rows * 2 * sizeof(int16_t));
+    s->x1 = s->x0 + s->rows;
+    for (int i = 0; i < s->rows; i++) {
+        int dy = lo + i;
+        int x0 = 0, x1 = 0;
+        for (int dx = lo; dx <= hi; dx++) {
+            if (dx*dx + dy*dy <= r2) {
+                if (x0 == x1) x0 = dx;
+                x1 = dx + 1;
+            }
+        }
+        s->x0[i] = x0;
+        s->x1[i] = x1;
+    }
+}
+
+static void free_spans(Spans *s) {
+    if (s->x0) free(s->x0);
+    s->x0 = s->x1 = NULL;
+}
+
+// 小鸟各部位的颜色（部位见 physics.h 的小鸟模型）
+static const uint32_t bird_part_color[] = {
+    [BIRD_PART_NONE] = COLOR_NONE, [BIRD_PART_PUPIL] = COLOR_PUPIL, [BIRD_PART_EYE] = COLOR_EYE,
+    [BIRD_PART_BEAK] = COLOR_BEAK, [BIRD_PART_WING] = COLOR_WING, [BIRD_PART_BODY] = COLOR_BIRD,
+};
+
+// 生成一个角度的小鸟精灵：对包围盒内每个像素取色，再把每行连续同色的像素合并成段。
+// 先数段数再分配，只在启动时执行
+static void build_bird_sprite(Sprite *sp, int r, int angle) {
+    int R = BIRD_MODEL_R(r);
+    sp->top = -R;
+    sp->rows = 2 * R;
+    sp->row_start = (int*)malloc((sp->rows + 1) * sizeof(int));
+    sp->runs = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+        int n = 0;
+        for (int i = 0; i < sp->rows; i++) {
+            sp->row_start[i] = n;
+            int dy = sp->top + i;
+            uint32_t cur = COLOR_NONE;
+            for (int dx = -R; dx <= R; dx++) {
+                uint32_t color = COLOR_NONE;
+                if (dx < R) color = bird_part_color[bird_sample(r, angle, dx, dy)];
+                if (color != cur && cur != COLOR_NONE) n++;  // 上一段结束
+                if (color != COLOR_NONE && color != cur && pass) {
+                    sp->runs[n] = (Run){ dx, 0, color };
+                }
+                if (color != COLOR_NONE && pass) sp->runs[n].len++;
+                cur = color;
+            }
+        }
+        sp->row_start[sp->rows] = n;
+        if (pass == 0) sp->runs = (Run*)malloc((n > 0 ? n : 1) * sizeof(Run));
+    }
+}
+
+static void free_sprite(Sprite *sp) {
+    if (sp->row_start) free(sp->row_start);
+    if (sp->runs) free(sp->runs);
+    sp->row_start = NULL;
+    sp->runs = NULL;
+}
+
+// 分配覆盖 [-R, R] 的空掩码
+static void init_mask(Mask *m, int R) {
+    m->left = m->top = -R;
+    m->w = m->h = 2 * R + 1;
+    m->words = (m->w + 31) / 32;
+    m->bits = (uint32_t*)malloc(m->h * m->words * sizeof(uint32_t));
+    memset(m->bits, 0, m->h * m->words * sizeof(uint32_t));
+    m->x0 = m->y0 = R + 1;
+    m->x1 = m->y1 = -R;
+}
+
+static void mask_set(Mask *m, int dx, int dy) {
+    int col = dx - m->left;
+    m->bits[(dy - m->top) * m->words + (col >> 5)] |= 1u << (col & 31);
+    if (dx < m->x0) m->x0 = dx;
+    if (dx + 1 > m->x1) m->x1 = dx + 1;
+    if (dy < m->y0) m->y0 = dy;
+    if (dy + 1 > m->y1) m->y1 = dy + 1;
+}
+
+static void free_mask(Mask *m) {
+    if (m->bits) free(m->bits);
+    m->bits = NULL;
+}
+
+// 小鸟的碰撞掩码：与精灵取自同一个模型，r 为屏幕分辨率下的半径
+static void build_bird_mask(Mask *m, int r, int angle) {
+    int R = BIRD_MODEL_R(r);
+    init_mask(m, R);
+    for (int dy = -R; dy < R; dy++) {
+        for (int dx = -R; dx < R; dx++) {
+            if (bird_sample(r, angle, dx, dy) != BIRD_PART_NONE) mask_set(m, dx, dy);
+        }
+    }
+}
+
+// 金币的碰撞掩码：与 draw_coins 画的外圈同形
+static void build_coin_mask(Mask *m, int r) {
+    init_mask(m, r);
+    for (int dy = -r; dy <= r; dy++) {
+        for (int dx = -r; dx <= r; dx++) {
+            if (dx*dx + dy*dy <= r*r) mask_set(m, dx, dy);
+        }
+    }
+}
+
+// 取掩码一行中从第 col 列开始的32位，超出掩码的位为0
+static uint32_t mask_word_at(const Mask *m, const uint32_t *row, int col) {
+    if (col <= -32 || col >= m->words * 32) return 0;
+    if (col < 0) return row[0] << -col;
+    int k = col >> 5, sh = col & 31;
+    uint32_t v = row[k] >> sh;
+    if (sh && k + 1 < m->words) v |= row[k + 1] << (32 - sh);
+    return v;
+}
+
+// 中心在 (ax, ay) 的掩码 a 与中心在 (bx, by) 的掩码 b 是否有重叠的像素：
+// 包围盒相交时才逐行把 b 对齐到 a 的字边界后按位与
+static bool masks_overlap(const Mask *a, int ax, int ay, const Mask *b, int bx, int by) {
+    if (ax + a->x1 <= bx + b->x0 || bx + b->x1 <= ax + a->x0) return false;
+    if (ay + a->y1 <= by + b->y0 || by + b->y1 <= ay + a->y0) return false;
+    int y0 = ay + a->y0 > by + b->y0 ? ay + a->y0 : by + b->y0;
+    int y1 = ay + a->y1 < by + b->y1 ? ay + a->y1 : by + b->y1;
+    int off = (ax + a->left) - (bx + b->left);  // a 的第0列在 b 中的列号
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *ra = a->bits + (y - ay - a->top) * a->words;
+        const uint32_t *rb = b->bits + (y - by - b->top) * b->words;
+        for (int k = 0; k < a->words; k++) {
+            if (ra[k] & mask_word_at(b, rb, off + 32 * k)) return true;
+        }
+    }
+    return false;
+}
+
+// 中心在 (cx, cy) 的掩码与矩形是否有重叠的像素
+static bool mask_hits_rect(const Mask *m, int cx, int cy, int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0) return false;
+    if (x + w <= cx + m->x0 || cx + m->x1 <= x) return false;
+    if (y + h <= cy + m->y0 || cy + m->y1 <= y) return false;
+    int y0 = y > cy + m->y0 ? y : cy + m->y0;
+    int y1 = y + h < cy + m->y1 ? y + h : cy + m->y1;
+    // 矩形在掩码中的列范围 [c0, c1)，换成首尾两个字的位掩码
+    int c0 = x - (cx + m->left), c1 = c0 + w;
+    if (c0 < 0) c0 = 0;
+    if (c1 > m->w) c1 = m->w;
+    int k0 = c0 >> 5, k1 = (c1 - 1) >> 5;
+    uint32_t first = ~0u << (c0 & 31);
+    uint32_t last = (c1 & 31) ? ~0u >> (32 - (c1 & 31)) : ~0u;
+    for (int yy = y0; yy < y1; yy++) {
+        const uint32_t *row = m->bits + (yy - cy - m->top) * m->words;
+        for (int k = k0; k <= k1; k++) {
+            uint32_t sel = (k == k0 ? first : ~0u) & (k == k1 ? last : ~0u);
+            if (row[k] & sel) return true;
+        }
+    }
+    return false;
+}
+
+// 在背景层横带上画矩形：纵向裁剪，横向首尾回绕
+static void layer_rect(Layer *l, int x, int y, int w, int h, uint32_t color) {
+    int W = game.fb_width;
+    if (y < 0) { h += y; y = 0; }
+    if (y + h > l->h) h = l->h - y;
+    if (w > W) w = W;
+    if (w <= 0 || h <= 0) return;
+    x = (x % W + W) % W;
+    int first = (x + w > W) ? W - x : w;
+    fill_rect(l->pix + y * W + x, W, first, h, color);
+    fill_rect(l->pix + y * W, W, w - first, h, color);
+}
+
+// 在背景层横带上画实心圆
+static void layer_disc(Layer *l, int cx, int cy, int r, uint32_t color) {
+    for (int dy = -r; dy <= r; dy++) {
+        int dx = 0;
+        while ((dx + 1) * (dx + 1) + dy * dy <= r * r) dx++;
+        layer_rect(l, cx - dx, cy + dy, 2 * dx + 1, 1, color);
+    }
+}
+
+// 背景图案和粒子用的伪随机数，不影响游戏本身的 rand() 序列
+static uint32_t fx_rand(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7fff;
+}
+
+static void init_layer(Layer *l, int y, int h, int speed) {
+    l->pix = (uint32_t*)malloc(game.fb_width * h * sizeof(uint32_t));
+    l->y = y;
+    l->h = h;
+    l->speed = speed;
+    l->pos = l->prev_pos = 0;
+    l->drawn_offset = -1;
+}
+
+// 生成三层背景：云（最慢）、远景楼群、地面（和管道同速），图案按缓冲区分辨率绘制
+static void build_layers() {
+    int W = game.fb_width;
+    int play_height = TO_FB(game.screen_height - game.ground_height);
+    uint32_t seed = 2024;
+
+    // 云层：天空底色上散布几朵由圆叠成的云
+    Layer *l = &layers[LAYER_CLOUDS];
+    init_layer(l, TO_FB(mul_scale(game.screen_height, CLOUD_TOP_RATIO, 100)),
+               TO_FB(mul_scale(game.screen_height, CLOUD_HEIGHT_RATIO, 100)), game.pipe_speed * SCALE / 4);
+    layer_rect(l, 0, 0, W, l->h, COLOR_BG);
+    int nr_clouds = W / 100 + 2;
+    for (int i = 0; i < nr_clouds; i++) {
+        int r = l->h / 6 + fx_rand(&seed) % (l->h / 8 + 1);
+        int cx = i * W / nr_clouds + fx_rand(&seed) % (W / nr_clouds / 2 + 1);
+        int cy = r + 1 + fx_rand(&seed) % (l->h - 2 * r - 1);
+        layer_rect(l, cx - 2 * r, cy, 4 * r, r, COLOR_CLOUD_SHADE);
+        layer_disc(l, cx - r, cy, r * 3 / 4, COLOR_CLOUD);
+        layer_disc(l, cx, cy - r / 3, r, COLOR_CLOUD);
+        layer_disc(l, cx + r, cy, r * 2 / 3, COLOR_CLOUD);
+        layer_rect(l, cx - r - r * 3 / 4, cy, 2 * r + r * 3 / 4 + r * 2 / 3, r * 2 / 3, COLOR_CLOUD);
+    }
+
+    // 远景楼群：紧贴地面的一排高低不一的楼，带窗户
+    l = &layers[LAYER_SKYLINE];
+    int sky_h = TO_FB(mul_scale(game.screen_height, SKYLINE_HEIGHT_RATIO, 100));
+    init_layer(l, play_height - sky_h, sky_h, game.pipe_speed * SCALE / 2);
+    layer_rect(l, 0, 0, W, l->h, COLOR_BG);
+    int min_w = W / 25 > FB_LEN(8) ? W / 25 : FB_LEN(8);
+    int win_w = FB_LEN(2), win_h = FB_LEN(3), win_margin = FB_LEN(3);
+    int win_dx = win_w + FB_LEN(3), win_dy = win_h + FB_LEN(3);
+    for (int x = 0; x < W; ) {
+        int bw = min_w + fx_rand(&seed) % (min_w * 3 / 2 + 1);
+        if (x + bw > W - min_w) bw = W - x;  // 最后一栋补齐到横带末尾，回绕处不留缝
+        int bh = sky_h * 3 / 10 + fx_rand(&seed) % (sky_h * 7 / 10);
+        layer_rect(l, x, sky_h - bh, bw - 1, bh, COLOR_SKYLINE);
+        for (int wy = sky_h - bh + win_margin; wy + win_margin <= sky_h; wy += win_dy) {
+            for (int wx = x + win_margin; wx + win_w <= x + bw - win_margin; wx += win_dx) {
+                layer_rect(l, wx, wy, win_w, win_h, COLOR_WINDOW);
+            }
+        }
+        x += bw;
+    }
+
+    // 地面：底色加白色短条纹
+    l = &layers[LAYER_GROUND];
+    init_layer(l, play_height, game.fb_height - play_height, game.pipe_speed * SCALE);
+    layer_rect(l, 0, 0, W, l->h, COLOR_GROUND);
+    for (int i = 0; i < W; i += W / 20) {
+        layer_rect(l, i, FB_LEN(5), W / 40, FB_LEN(2), COLOR_TEXT);
+    }
+}
+
 // 初始化缓冲区
 static void init_buffers() {
     // 初始化全屏缓冲区
-    game.frame_buf = (uint32_t*)malloc(game.screen_width * game.screen_height * sizeof(uint32_t));
+    game.frame_buf = (uint32_t*)malloc(game.fb_width * game.fb_height * sizeof(uint32_t));
+#if RENDER_SHIFT > 0
+    // 放大上传用的行缓冲：缓冲区一行放大后的 RENDER_SCALE 行
+    scale_buf = (uint32_t*)malloc((game.fb_width << RENDER_SHIFT) * RENDER_SCALE * sizeof(uint32_t));
+#endif
     // 字符缓冲区（16x16像素，更大尺寸使字体更圆滑）
     char_buf = (uint32_t*)malloc(16 * 16 * sizeof(uint32_t));
+
+    // 小鸟各个倾斜角度的精灵
+    int r = TO_FB(game.bird_size / 2);
+    for (int i = 0; i < BIRD_ANGLES; i++) {
+        build_bird_sprite(&bird_sprites[i], r, i);
+    }
+    bird_sprite_r = (BIRD_MODEL_R(r) << RENDER_SHIFT) + RENDER_SCALE;
+
+    // 碰撞掩码按屏幕分辨率生成，与 RENDER_SHIFT 无关
+    for (int i = 0; i < BIRD_ANGLES; i++) {
+        build_bird_mask(&bird_masks[i], game.bird_size / 2, i);
+    }
+    build_coin_mask(&coin_mask, game.coin_size / 2);
+
+    // 金币的圆形只和尺寸有关，预先算好逐行跨度（缓冲区分辨率）
+    r = TO_FB(game.coin_size / 2);
+    int inner = r - FB_LEN(2);
+    build_spans(&coin_outer_spans, -r, r, r * r);
+    build_spans(&coin_inner_spans, -inner, inner, inner * inner);
+    r = FB_LEN(4);
+    build_spans(&coin_icon_spans, -r, r, r * r);
+    for (int k = 0; k < PARTICLE_SIZES; k++) {
+        r = TO_FB(PARTICLE_SIZES - 1 - k);
+        build_spans(&particle_spans[k], -r, r, r * r + r);
+    }
+
+    // 背景层
+    build_layers();
+
+#if defined(SPAN_RENDER) || defined(BENCH)
+    span_particles.bucket = (int*)malloc((game.fb_height + 1) * sizeof(int));
+#endif
 }
 
 // 释放缓冲区
 static void free_buffers() {
     if (game.frame_buf) free(game.frame_buf);
+#if RENDER_SHIFT > 0
+    if (scale_buf) free(scale_buf);
+    scale_buf = NULL;
+#endif
     if (char_buf) free(char_buf);
+    for (int i = 0; i < BIRD_ANGLES; i++) {
+        free_sprite(&bird_sprites[i]);
+        free_mask(&bird_masks[i]);
+    }
+    free_mask(&coin_mask);
+    free_spans(&coin_outer_spans);
+    free_spans(&coin_inner_spans);
+    free_spans(&coin_icon_spans);
+    for (int k = 0; k < PARTICLE_SIZES; k++) {
+        free_spans(&particle_spans[k]);
+    }
+    for (int i = 0; i < NR_LAYERS; i++) {
+        if (layers[i].pix) free(layers[i].pix);
+        layers[i].pix = NULL;
+    }
+#if defined(SPAN_RENDER) || defined(BENCH)
+    if (span_particles.bucket) free(span_particles.bucket);
+    span_particles.bucket = NULL;
+#endif
 }
 
 // 初始化游戏状态
@@ -125,6 +583,8 @@ static void init_game() {
     AM_GPU_CONFIG_T gpu_cfg = io_read(AM_GPU_CONFIG);
     game.screen_width = gpu_cfg.width;
     game.screen_height = gpu_cfg.height;
+    game.fb_width = TO_FB_END(game.screen_width);
+    game.fb_height = TO_FB_END(game.screen_height);
     
     // 根据屏幕尺寸计算元素实际大小（使用整数运算）
     game.bird_size = mul_scale(game.screen_height, BIRD_SIZE_RATIO, 100);
@@ -135,32 +595,21 @@ static void init_game() {
     game.coin_size = mul_scale(game.screen_height, COIN_SIZE_RATIO, 100);
     
     // 确保最小尺寸
-    if (game.pipe_speed < 1) game.pipe_speed = 1;
-    if (game.bird_size < 8) game.bird_size = 8;
-    if (game.pipe_width < 20) game.pipe_width = 20;
+    if (game.pipe_speed < MIN_PIPE_SPEED) game.pipe_speed = MIN_PIPE_SPEED;
+    if (game.bird_size < MIN_BIRD_SIZE) game.bird_size = MIN_BIRD_SIZE;
+    if (game.pipe_width < MIN_PIPE_WIDTH) game.pipe_width = MIN_PIPE_WIDTH;
     if (game.coin_size < 6) game.coin_size = 6;  // 金币最小尺寸
     
     // 初始化小鸟位置（屏幕左侧中间）
     game.bird_y = game.screen_height * SCALE / 2;  // 中间位置
+    game.prev_bird_y = game.bird_y;
     game.velocity = 0;
 
-    // 初始化管道
-    memset(game.pipes, 0, sizeof(game.pipes));
-    for (int i = 0; i < 5; i++) {
-        game.pipes[i].x = -game.pipe_width;  // 初始位置在左侧屏幕外
-        game.pipes[i].passed = false;
-        game.pipes[i].active = false;
-    }
-    game.active_pipes = 0;
-
-    // 初始化金币
-    memset(game.coins, 0, sizeof(game.coins));
-    for (int i = 0; i < 10; i++) {
-        game.coins[i].x = -game.coin_size;  // 初始位置在左侧屏幕外
-        game.coins[i].collected = false;
-        game.coins[i].active = false;
-    }
-    game.active_coins = 0;
+    // 初始化管道队列和金币池
+    game.pipe_head = 0;
+    game.pipe_count = 0;
+    game.pipe_ahead = 0;
+    game.coins.count = 0;
 
     // 初始化分数
     game.score = 0;
@@ -168,7 +617,20 @@ static void init_game() {
 
     // 初始化游戏状态
     game.state = GAME_RUNNING;
-    game.ground_offset = 0;
+    game.alpha = SCALE;
+
+    // 重置后第一帧整屏上传
+    game.dirty_count = 0;
+    game.full_redraw = true;
+    game.bird_drawn = false;
+    game.drawn_score = -1;
+    game.drawn_coin_score = -1;
+    game.game_over_drawn = false;
+
+    // 清空粒子
+    particles.head = 0;
+    particles.count = 0;
+    particles_drawn = false;
 
     // 初始化缓冲区
     init_buffers();
@@ -177,247 +639,442 @@ static void init_game() {
     srand((unsigned int)io_read(AM_TIMER_UPTIME).us);
 }
 
-// 向缓冲区绘制像素
-static void frame_buf_set_pixel(int x, int y, uint32_t color) {
-    if (x >= 0 && x < game.screen_width && y >= 0 && y < game.screen_height) {
-        game.frame_buf[y * game.screen_width + x] = color;
+// 记录一块需要上传的区域（裁剪到屏幕内）
+static void mark_dirty(int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > game.screen_width) w = game.screen_width - x;
+    if (y + h > game.screen_height) h = game.screen_height - y;
+    if (w <= 0 || h <= 0) return;
+
+    if (game.dirty_count >= MAX_DIRTY) {
+        game.full_redraw = true;
+        return;
     }
+    game.dirty[game.dirty_count++] = (Rect){ x, y, w, h };
+}
+
+// 记录两个同尺寸矩形（旧位置和新位置）覆盖的区域
+static void mark_dirty_moved(int old_x, int old_y, int new_x, int new_y, int w, int h) {
+    int x0 = old_x < new_x ? old_x : new_x;
+    int y0 = old_y < new_y ? old_y : new_y;
+    int x1 = (old_x > new_x ? old_x : new_x) + w;
+    int y1 = (old_y > new_y ? old_y : new_y) + h;
+    // 两次位置相距较远时分开记录，避免把中间区域也带上
+    if (x1 - x0 > 2 * w || y1 - y0 > 2 * h) {
+        mark_dirty(old_x, old_y, w, h);
+        mark_dirty(new_x, new_y, w, h);
+    } else {
+        mark_dirty(x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+// 管道（含顶部凸沿）占据的区域
+static void mark_pipe_dirty(int x) {
+    mark_dirty(x - PIPE_LIP_OVERHANG, 0, game.pipe_width + 2 * PIPE_LIP_OVERHANG,
+               game.screen_height - game.ground_height);
+}
+
+// 金币占据的区域
+static void mark_coin_dirty(int x, int y, int size) {
+    mark_dirty(x - size/2, y - size/2, size/2 * 2 + 1, size/2 * 2 + 1);
+}
+
+// 管道离开屏幕：上一帧画过的位置需要重新上传
+static void erase_pipe(Pipe *p) {
+    if (p->drawn) mark_pipe_dirty(p->drawn_x);
+    p->drawn = false;
+}
+
+// 金币被收集或离开屏幕
+static void erase_coin(int i) {
+    if (game.coins.drawn[i]) mark_coin_dirty(game.coins.drawn_x[i], game.coins.drawn_y[i], game.coin_size);
+    game.coins.drawn[i] = false;
+}
+
+// 队列中第i个（从最左边数）管道
+static Pipe *pipe_at(int i) {
+    return &game.pipes[(game.pipe_head + i) & (MAX_PIPES - 1)];
+}
+
+// 移除第i个金币：擦除后用最后一个金币填补
+static void remove_coin(int i) {
+    CoinPool *c = &game.coins;
+    erase_coin(i);
+    int last = --c->count;
+    c->x[i] = c->x[last];
+    c->prev_x[i] = c->prev_x[last];
+    c->y[i] = c->y[last];
+    c->drawn[i] = c->drawn[last];
+    c->drawn_x[i] = c->drawn_x[last];
+    c->drawn_y[i] = c->drawn_y[last];
 }
 
-// 绘制实心矩形到缓冲区
-static void draw_rect(int x, int y, int w, int h, uint32_t color) {
-    // 检查绘制区域是否在屏幕内
-    if (x >= game.screen_width || y >= game.screen_height ||
-        x + w <= 0 || y + h <= 0) return;
+// 绘制实心矩形到缓冲区（屏幕坐标）
+static void draw_rect(const Band *b, int x, int y, int w, int h, uint32_t color) {
+    // 换算到缓冲区坐标
+    int x1 = TO_FB_END(x + w), y1 = TO_FB_END(y + h);
+    x = TO_FB(x);
+    y = TO_FB(y);
+
+    // 检查绘制区域是否在屏幕（裁剪带）内
+    if (x >= game.fb_width || y >= b->y1 ||
+        x1 <= 0 || y1 <= b->y0) return;
 
     // 调整绘制区域（裁剪超出屏幕的部分）
     int draw_x = x < 0 ? 0 : x;
-    int draw_y = y < 0 ? 0 : y;
-    int draw_w = (x + w > game.screen_width) ? (game.screen_width - x) : w;
-    int draw_h = (y + h > game.screen_height) ? (game.screen_height - y) : h;
+    int draw_y = y < b->y0 ? b->y0 : y;
+    int draw_w = ((x1 > game.fb_width) ? game.fb_width : x1) - draw_x;
+    int draw_h = ((y1 > b->y1) ? b->y1 : y1) - draw_y;
     if (draw_w <= 0 || draw_h <= 0) return;
 
     // 填充到缓冲区
-    for (int i = 0; i < draw_h; i++) {
-        int row = (draw_y + i) * game.screen_width + draw_x;
-        for (int j = 0; j < draw_w; j++) {
-            game.frame_buf[row + j] = color;
+    fill_rect(game.frame_buf + draw_y * game.fb_width + draw_x, game.fb_width,
+              draw_w, draw_h, color);
+}
+
+// 按跨度表在 (cx, cy) 处（屏幕坐标）绘制圆形，整行裁剪后连续填充
+static void draw_spans(const Band *b, const Spans *s, int cx, int cy, uint32_t color) {
+    cx = TO_FB(cx);
+    cy = TO_FB(cy);
+    int y0 = cy + s->top;
+    int begin = y0 < b->y0 ? b->y0 - y0 : 0;
+    int end = (y0 + s->rows > b->y1) ? b->y1 - y0 : s->rows;
+    for (int i = begin; i < end; i++) {
+        int x0 = cx + s->x0[i];
+        int x1 = cx + s->x1[i];
+        if (x0 < 0) x0 = 0;
+        if (x1 > game.fb_width) x1 = game.fb_width;
+        fill_row(game.frame_buf + (y0 + i) * game.fb_width + x0, x1 - x0, color);
+    }
+}
+
+// 渲染插值：按 game.alpha 在上一物理步和当前物理步的值之间取值
+static int lerp_state(int prev, int cur) {
+    return prev + (cur - prev) * game.alpha / SCALE;
+}
+
+// 各元素在本次渲染时的屏幕位置
+static int bird_render_y() {
+    return lerp_state(game.prev_bird_y, game.bird_y) / SCALE;
+}
+
+static int pipe_render_x(const Pipe *p) {
+    return lerp_state(p->prev_x, p->x);
+}
+
+static int coin_render_x(int i) {
+    return lerp_state(game.coins.prev_x[i], game.coins.x[i]);
+}
+
+// 背景层本次渲染的偏移（0 ~ fb_width-1）；回绕时 prev_pos 可能为负，先补一整圈再取整
+static int layer_render_offset(const Layer *l) {
+    int wrap = (game.fb_width << RENDER_SHIFT) * SCALE;
+    return TO_FB((lerp_state(l->prev_pos, l->pos) + wrap) / SCALE % (game.fb_width << RENDER_SHIFT));
+}
+
+// 每个物理步推进背景层，滚过一整圈（横带宽度对应的屏幕距离）后两个位置一起减掉一圈
+static void scroll_layers() {
+    int wrap = (game.fb_width << RENDER_SHIFT) * SCALE;
+    for (int i = 0; i < NR_LAYERS; i++) {
+        Layer *l = &layers[i];
+        l->pos += l->speed * PHYSICS_DIV;
+        if (l->pos >= wrap) {
+            l->pos -= wrap;
+            l->prev_pos -= wrap;
         }
     }
 }
 
-// 绘制小鸟（圆形）
-static void draw_bird() {
-    int bird_x = game.screen_width / 4;  // 小鸟固定x坐标
-    int bird_y = game.bird_y / SCALE;    // 转换为实际坐标
-    
-    // 绘制圆形小鸟
-    for (int dy = -game.bird_size/2; dy < game.bird_size/2; dy++) {
-        for (int dx = -game.bird_size/2; dx < game.bird_size/2; dx++) {
-            // 圆形公式：x² + y² <= r²
-            if (dx*dx + dy*dy <= (game.bird_size/2)*(game.bird_size/2)) {
-                int x = bird_x + dx;
-                int y = bird_y + dy;
-                frame_buf_set_pixel(x, y, COLOR_BIRD);
-            }
+// 把背景层拷贝到缓冲区：每行分 [offset, W) 和 [0, offset) 两段
+static void draw_layer(const Band *b, const Layer *l) {
+    int W = game.fb_width;
+    int offset = layer_render_offset(l);
+    int begin = b->y0 > l->y ? b->y0 - l->y : 0;
+    int end = b->y1 < l->y + l->h ? b->y1 - l->y : l->h;
+    for (int i = begin; i < end; i++) {
+        uint32_t *dst = game.frame_buf + (l->y + i) * W;
+        const uint32_t *src = l->pix + i * W;
+        copy_row(dst, src + offset, W - offset);
+        copy_row(dst + W - offset, src, offset);
+    }
+}
+
+// 用纯色填满缓冲区的 [y0, y1) 行中落在裁剪带内的部分
+static void fill_band_rows(const Band *b, int y0, int y1, uint32_t color) {
+    if (y0 < b->y0) y0 = b->y0;
+    if (y1 > b->y1) y1 = b->y1;
+    if (y1 <= y0) return;
+    fill_rect(game.frame_buf + y0 * game.fb_width, game.fb_width, game.fb_width, y1 - y0, color);
+}
+
+// 绘制天空：云层和楼群之外的天空是纯色
+static void draw_background(const Band *b) {
+    const Layer *clouds = &layers[LAYER_CLOUDS];
+    const Layer *skyline = &layers[LAYER_SKYLINE];
+    fill_band_rows(b, 0, clouds->y, COLOR_BG);
+    draw_layer(b, clouds);
+    fill_band_rows(b, clouds->y + clouds->h, skyline->y, COLOR_BG);
+    draw_layer(b, skyline);
+}
+
+// 按行程编码画精灵，中心在 (cx, cy)（屏幕坐标），只画不透明的段
+static void draw_sprite(const Band *b, const Sprite *sp, int cx, int cy) {
+    cx = TO_FB(cx);
+    cy = TO_FB(cy);
+    int y0 = cy + sp->top;
+    int begin = y0 < b->y0 ? b->y0 - y0 : 0;
+    int end = (y0 + sp->rows > b->y1) ? b->y1 - y0 : sp->rows;
+    for (int i = begin; i < end; i++) {
+        uint32_t *row = game.frame_buf + (y0 + i) * game.fb_width;
+        for (int k = sp->row_start[i]; k < sp->row_start[i + 1]; k++) {
+            const Run *run = &sp->runs[k];
+            int x0 = cx + run->x;
+            int x1 = x0 + run->len;
+            if (x0 < 0) x0 = 0;
+            if (x1 > game.fb_width) x1 = game.fb_width;
+            if (x1 > x0) fill_row(row + x0, x1 - x0, run->color);
         }
     }
 }
 
-// 生成新管道（右侧）
-static void spawn_pipe() {
-    if (game.active_pipes >= 5) return;  // 达到最大管道数
-
-    // 找到空管道位置
-    for (int i = 0; i < 5; i++) {
-        if (!game.pipes[i].active) {  // 只使用非活动管道
-            // 生成管道位置（右侧屏幕外）
-            game.pipes[i].x = game.screen_width;
-            // 随机生成间隙位置
-            int min_gap = game.ground_height + game.pipe_gap/2 + 20;
-            int max_gap = game.screen_height - game.ground_height - game.pipe_gap/2 - 20;
-            game.pipes[i].gap_y = min_gap + (rand() % (max_gap - min_gap + 1));
-            game.pipes[i].passed = false;
-            game.pipes[i].active = true;  // 标记为活动
-            game.active_pipes++;
-            
-            // 有30%概率在管道间隙生成金币
-            if (rand() % 10 < 3) {
-                // 在管道间隙附近随机位置生成金币
-                int coin_x = game.screen_width + game.pipe_width/2;
-                int coin_y = game.pipes[i].gap_y - game.pipe_gap/4 + 
-                            (rand() % (game.pipe_gap/2));
-                // 尝试生成金币
-                for (int c = 0; c < 10; c++) {
-                    if (!game.coins[c].active) {
-                        game.coins[c].x = coin_x;
-                        game.coins[c].y = coin_y;
-                        game.coins[c].size = game.coin_size;
-                        game.coins[c].collected = false;
-                        game.coins[c].active = true;
-                        game.active_coins++;
-                        break;
-                    }
-                }
-            }
-            break;
+static int bird_angle() {
+    return bird_angle_of(game.velocity);
+}
+
+// 绘制小鸟（按速度倾斜的精灵）
+static void draw_bird(const Band *b) {
+    int bird_x = BIRD_X(game.screen_width);  // 小鸟固定x坐标
+    int bird_y = bird_render_y();        // 转换为实际坐标
+    
+    draw_sprite(b, &bird_sprites[bird_angle()], bird_x, bird_y);
+}
+
+// 生成管道，late 为本步内已经错过的基础步数（这段时间管道已经左移）
+static void spawn_pipe(int late) {
+    if (game.pipe_count >= MAX_PIPES) return;  // 达到最大管道数
+
+    Pipe *p = pipe_at(game.pipe_count++);
+    // 生成管道位置（右侧屏幕外）
+    p->x = game.screen_width - late * game.pipe_speed;
+    p->prev_x = p->x;
+    p->drawn = false;
+    // 随机生成间隙位置
+    int min_gap = game.ground_height + game.pipe_gap/2 + PIPE_GAP_MARGIN;
+    int max_gap = game.screen_height - game.ground_height - game.pipe_gap/2 - PIPE_GAP_MARGIN;
+    p->gap_y = min_gap + (rand() % (max_gap - min_gap + 1));
+
+    // 有30%概率在管道间隙生成金币
+    if (rand() % 10 < 3) {
+        // 在管道间隙附近随机位置生成金币
+        int coin_x = p->x + game.pipe_width/2;
+        int coin_y = p->gap_y - game.pipe_gap/4 + 
+                    (rand() % (game.pipe_gap/2));
+        CoinPool *c = &game.coins;
+        if (c->count < MAX_COINS) {
+            int i = c->count++;
+            c->x[i] = coin_x;
+            c->prev_x[i] = coin_x;
+            c->y[i] = coin_y;
+            c->drawn[i] = false;
         }
     }
 }
 
 // 绘制管道
-static void draw_pipes() {
-    for (int i = 0; i < 5; i++) {
-        Pipe *p = &game.pipes[i];
-        // 只绘制活动且在屏幕范围内的管道
-        if (!p->active) continue;
-        if (p->x > game.screen_width) continue;    // 完全在右侧不绘制
-        if (p->x + game.pipe_width < 0) continue;  // 完全在左侧不绘制
+static void draw_pipes(const Band *b) {
+    for (int i = 0; i < game.pipe_count; i++) {
+        Pipe *p = pipe_at(i);
+        // 只绘制在屏幕范围内的管道
+        int x = pipe_render_x(p);
+        if (x > game.screen_width) continue;    // 完全在右侧不绘制
+        if (x + game.pipe_width < 0) continue;  // 完全在左侧不绘制
 
         // 绘制上管道
-        draw_rect(p->x, 0, game.pipe_width, p->gap_y - game.pipe_gap/2, COLOR_PIPE);
+        draw_rect(b, x, 0, game.pipe_width, p->gap_y - game.pipe_gap/2, COLOR_PIPE);
         // 绘制上管道顶部
-        draw_rect(p->x - 2, p->gap_y - game.pipe_gap/2, game.pipe_width + 4, 6, COLOR_PIPE_TOP);
+        draw_rect(b, x - PIPE_LIP_OVERHANG, p->gap_y - game.pipe_gap/2,
+                  game.pipe_width + 2 * PIPE_LIP_OVERHANG, PIPE_LIP_HEIGHT, COLOR_PIPE_TOP);
         
         // 绘制下管道
         int lower_pipe_height = game.screen_height - (p->gap_y + game.pipe_gap/2) - game.ground_height;
-        draw_rect(p->x, p->gap_y + game.pipe_gap/2, game.pipe_width, lower_pipe_height, COLOR_PIPE);
+        draw_rect(b, x, p->gap_y + game.pipe_gap/2, game.pipe_width, lower_pipe_height, COLOR_PIPE);
         // 绘制下管道顶部
-        draw_rect(p->x - 2, p->gap_y + game.pipe_gap/2 - 6, game.pipe_width + 4, 6, COLOR_PIPE_TOP);
+        draw_rect(b, x - PIPE_LIP_OVERHANG, p->gap_y + game.pipe_gap/2 - PIPE_LIP_HEIGHT,
+                  game.pipe_width + 2 * PIPE_LIP_OVERHANG, PIPE_LIP_HEIGHT, COLOR_PIPE_TOP);
     }
 }
 
 // 绘制金币（带边框的圆形）
-static void draw_coins() {
-    for (int i = 0; i < 10; i++) {
-        Coin *c = &game.coins[i];
-        if (!c->active || c->collected) continue;  // 只绘制活动且未收集的金币
-        if (c->x > game.screen_width) continue;    // 完全在右侧不绘制
-        if (c->x + c->size < 0) continue;          // 完全在左侧不绘制
-
-        // 绘制金币边框（橙色）
-        for (int dy = -c->size/2; dy <= c->size/2; dy++) {
-            for (int dx = -c->size/2; dx <= c->size/2; dx++) {
-                int dist_sq = dx*dx + dy*dy;
-                // 边框范围：(r-1)^2 <= x²+y² <= r²
-                if (dist_sq <= (c->size/2)*(c->size/2) && 
-                    dist_sq >= ((c->size/2 - 2)*(c->size/2 - 2))) {
-                    int x = c->x + dx;
-                    int y = c->y + dy;
-                    frame_buf_set_pixel(x, y, COLOR_COIN_BORDER);
-                }
-            }
-        }
+static void draw_coins(const Band *b) {
+    for (int i = 0; i < game.coins.count; i++) {
+        int x = coin_render_x(i);
+        int y = game.coins.y[i];
+        if (x > game.screen_width) continue;        // 完全在右侧不绘制
+        if (x + game.coin_size < 0) continue;       // 完全在左侧不绘制
+
+        // 先画整个圆作为边框（橙色），再在内部画金色小圆
+        draw_spans(b, &coin_outer_spans, x, y, COLOR_COIN_BORDER);
+        draw_spans(b, &coin_inner_spans, x, y, COLOR_COIN);
+    }
+}
 
-        // 绘制金币内部（金色）
-        for (int dy = -(c->size/2 - 2); dy <= (c->size/2 - 2); dy++) {
-            for (int dx = -(c->size/2 - 2); dx <= (c->size/2 - 2); dx++) {
-                if (dx*dx + dy*dy <= ((c->size/2 - 2)*(c->size/2 - 2))) {
-                    int x = c->x + dx;
-                    int y = c->y + dy;
-                    frame_buf_set_pixel(x, y, COLOR_COIN);
-                }
-            }
-        }
+// 第i个粒子的插值位置（屏幕坐标）：上一步的位置由当前位置和速度倒推（见 move_particles）
+static int particle_render_x(int i) {
+    return lerp_state(particles.x[i] - PHYSICS_DIV * particles.vx[i], particles.x[i]) / SCALE;
+}
+
+static int particle_render_y(int i) {
+    const int k = PHYSICS_DIV;
+    int prev = particles.y[i] - k * particles.vy[i] + PARTICLE_GRAVITY * k * (k + 1) / 2;
+    return lerp_state(prev, particles.y[i]) / SCALE;
+}
+
+// 粒子随年龄逐级缩小，每级是预先算好的圆点
+static void draw_particles(const Band *b) {
+    int pad = FB_LEN(PARTICLE_SIZES);
+    for (int k = 0; k < particles.count; k++) {
+        int i = (particles.head + k) & (MAX_PARTICLES - 1);
+        int y = particle_render_y(i);
+        int fy = TO_FB(y);
+        if (fy + pad < b->y0 || fy - pad >= b->y1) continue;  // 不在本条带内
+        int size = (particles.tick - particles.born[i]) * PARTICLE_SIZES / PARTICLE_TICKS;
+        draw_spans(b, &particle_spans[size], particle_render_x(i), y, particles.color[i]);
     }
 }
 
-static void update_pipes_and_coins() {
-    for (int i = 0; i < 5; i++) {
-        Pipe *p = &game.pipes[i];
-        if (!p->active) continue;
+// 生成一个粒子，池满时覆盖最旧的
+static void spawn_particle(int x, int y, int vx, int vy, uint32_t color) {
+    if (particles.count == MAX_PARTICLES) {
+        particles.head = (particles.head + 1) & (MAX_PARTICLES - 1);
+        particles.count--;
+    }
+    int i = (particles.head + particles.count++) & (MAX_PARTICLES - 1);
+    particles.x[i] = x;
+    particles.y[i] = y;
+    particles.vx[i] = vx;
+    particles.vy[i] = vy;
+    particles.color[i] = color;
+    particles.born[i] = particles.tick;
+}
 
-        p->x -= game.pipe_speed;
+// 在 (x, y)（屏幕坐标）迸出 n 个粒子：水平速度在 [-spread, spread]、竖直速度在
+// [-lift, spread - lift] 内随机（* SCALE），整体再加上 drift 的水平速度，颜色在 c0、c1 间交替
+static void particle_burst(int x, int y, int n, int spread, int lift, int drift, uint32_t c0, uint32_t c1) {
+    for (int k = 0; k < n; k++) {
+        int vx = (int)(fx_rand(&particles.seed) % (2 * spread + 1)) - spread + drift;
+        int vy = (int)(fx_rand(&particles.seed) % (spread + 1)) - lift;
+        spawn_particle(x * SCALE, y * SCALE, vx, vy, (k & 1) ? c1 : c0);
+    }
+}
 
-        if (p->x + game.pipe_width < 0) {
-            p->active = false;
-            game.active_pipes--;
-        }
+// 一个物理步内的 PHYSICS_DIV 个基础步一次算完（每个基础步先移动再加重力）
+static void move_particles(int from, int to) {
+    const int k = PHYSICS_DIV;
+    for (int i = from; i < to; i++) {
+        particles.x[i] += k * particles.vx[i];
+        particles.y[i] += k * particles.vy[i] + PARTICLE_GRAVITY * k * (k - 1) / 2;
+        particles.vy[i] += k * PARTICLE_GRAVITY;
     }
+}
 
-    for (int i = 0; i < 10; i++) {
-        Coin *c = &game.coins[i];
-        if (!c->active || c->collected) continue;
+// 推进一个物理步：先从队头丢掉过期的粒子，再把环形池中活着的部分按一两段连续区间
+// 更新，循环体里没有分支，便于编译器向量化
+static void update_particles() {
+    particles.tick += PHYSICS_DIV;
+    while (particles.count > 0 && particles.tick - particles.born[particles.head] >= PARTICLE_TICKS) {
+        particles.head = (particles.head + 1) & (MAX_PARTICLES - 1);
+        particles.count--;
+    }
+    int end = particles.head + particles.count;
+    move_particles(particles.head, end < MAX_PARTICLES ? end : MAX_PARTICLES);
+    if (end > MAX_PARTICLES) move_particles(0, end - MAX_PARTICLES);
+}
 
-        c->x -= game.pipe_speed;
+static void update_pipes_and_coins() {
+    int dx = game.pipe_speed * PHYSICS_DIV;  // 本步移动的距离
+    for (int i = 0; i < game.pipe_count; i++) {
+        pipe_at(i)->x -= dx;
+    }
+    // 离开屏幕的只可能是队首的管道
+    while (game.pipe_count > 0 && pipe_at(0)->x + game.pipe_width < 0) {
+        erase_pipe(pipe_at(0));
+        game.pipe_head = (game.pipe_head + 1) & (MAX_PIPES - 1);
+        game.pipe_count--;
+        if (game.pipe_ahead > 0) game.pipe_ahead--;
+    }
 
-        if (c->x + c->size < 0) {
-            c->active = false;
-            game.active_coins--;
+    CoinPool *c = &game.coins;
+    for (int i = c->count - 1; i >= 0; i--) {
+        c->x[i] -= dx;
+        if (c->x[i] + game.coin_size < 0) {
+            remove_coin(i);
         }
     }
 
     static int spawn_timer = 0;
     int spawn_interval = (game.screen_width / game.pipe_speed) / 2;
-    if (spawn_interval < 60) spawn_interval = 60;
+    if (spawn_interval < PIPE_SPAWN_MIN_TICKS) spawn_interval = PIPE_SPAWN_MIN_TICKS;
 
-    if (++spawn_timer >= spawn_interval) {
-        spawn_pipe();
-        spawn_timer = 0;
+    spawn_timer += PHYSICS_DIV;
+    if (spawn_timer >= spawn_interval) {
+        spawn_timer -= spawn_interval;
+        spawn_pipe(spawn_timer);
     }
 }
 
 
 // 绘制地面
-static void draw_ground() {
-    // 绘制地面矩形
-    draw_rect(0, game.screen_height - game.ground_height, 
-              game.screen_width, game.ground_height, COLOR_GROUND);
-    
-    // 绘制地面纹理
-    for (int i = 0; i < game.screen_width; i += game.screen_width / 20) {
-        int x = (i + game.ground_offset) % game.screen_width;
-        draw_rect(x, game.screen_height - game.ground_height + 5, 
-                  game.screen_width / 40, 2, COLOR_TEXT);
-    }
-    
-    // 更新地面滚动偏移
-    game.ground_offset = (game.ground_offset - game.pipe_speed + game.screen_width) % game.screen_width;
-}
-
-static void draw_char(int x, int y, char c, uint32_t color) {
-    //const int size = 16;
-    static const uint8_t font[11][16] = {
-        // 0
-        {0b00111100, 0b01111110, 0b11000011, 0b11000011,
-         0b11000011, 0b11000011, 0b01111110, 0b00111100},
-        // 1
-        {0b00011000, 0b00111000, 0b01111000, 0b00011000,
-         0b00011000, 0b00011000, 0b00111100, 0b00111100},
-        // 2
-        {0b01111110, 0b11000110, 0b00000110, 0b00001100,
-         0b00011000, 0b00110000, 0b11111111, 0b11111111},
-        // 3
-        {0b01111110, 0b11000110, 0b00000110, 0b00111100,
-         0b00000110, 0b11000110, 0b01111110, 0b00000000},
-        // 4
-        {0b00001100, 0b00011100, 0b00101100, 0b01001100,
-         0b11111111, 0b11111111, 0b00001100, 0b00000000},
-        // 5
-        {0b11111111, 0b11111111, 0b11000000, 0b11111100,
-         0b00000110, 0b00000110, 0b11111110, 0b11000000},
-        // 6
-        {0b00111100, 0b01111110, 0b11000000, 0b11111100,
-         0b11000110, 0b11000110, 0b01111110, 0b00000000},
-        // 7
-        {0b11111111, 0b11111111, 0b00000110, 0b00001100,
-         0b00011000, 0b00110000, 0b00110000, 0b00110000},
-        // 8
-        {0b01111110, 0b11000110, 0b01111110, 0b11000110,
-         0b11000110, 0b11000110, 0b01111110, 0b00000000},
-        // 9
-        {0b01111110, 0b11000110, 0b11000110, 0b01111110,
-         0b00000110, 0b00000110, 0b01111110, 0b00000000},
-        // + (10)
-        {0b00000000, 0b00011000, 0b00011000, 0b11111111,
-         0b11111111, 0b00011000, 0b00011000, 0b00000000}
-    };
-
-    int index = -1;
-    if (c >= '0' && c <= '9') index = c - '0';
-    else if (c == '+') index = 10;
-
-    if (index < 0 || index > 10) return;
+static void draw_ground(const Band *b) {
+    draw_layer(b, &layers[LAYER_GROUND]);
+}
+
+// 8x8 点阵字体：数字和加号，绘制时每个点放大为 2x2
+static const uint8_t font[11][16] = {
+    // 0
+    {0b00111100, 0b01111110, 0b11000011, 0b11000011,
+     0b11000011, 0b11000011, 0b01111110, 0b00111100},
+    // 1
+    {0b00011000, 0b00111000, 0b01111000, 0b00011000,
+     0b00011000, 0b00011000, 0b00111100, 0b00111100},
+    // 2
+    {0b01111110, 0b11000110, 0b00000110, 0b00001100,
+     0b00011000, 0b00110000, 0b11111111, 0b11111111},
+    // 3
+    {0b01111110, 0b11000110, 0b00000110, 0b00111100,
+     0b00000110, 0b11000110, 0b01111110, 0b00000000},
+    // 4
+    {0b00001100, 0b00011100, 0b00101100, 0b01001100,
+     0b11111111, 0b11111111, 0b00001100, 0b00000000},
+    // 5
+    {0b11111111, 0b11111111, 0b11000000, 0b11111100,
+     0b00000110, 0b00000110, 0b11111110, 0b11000000},
+    // 6
+    {0b00111100, 0b01111110, 0b11000000, 0b11111100,
+     0b11000110, 0b11000110, 0b01111110, 0b00000000},
+    // 7
+    {0b11111111, 0b11111111, 0b00000110, 0b00001100,
+     0b00011000, 0b00110000, 0b00110000, 0b00110000},
+    // 8
+    {0b01111110, 0b11000110, 0b01111110, 0b11000110,
+     0b11000110, 0b11000110, 0b01111110, 0b00000000},
+    // 9
+    {0b01111110, 0b11000110, 0b11000110, 0b01111110,
+     0b00000110, 0b00000110, 0b01111110, 0b00000000},
+    // + (10)
+    {0b00000000, 0b00011000, 0b00011000, 0b11111111,
+     0b11111111, 0b00011000, 0b00011000, 0b00000000}
+};
+
+static int font_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c == '+') return 10;
+    return -1;
+}
+
+static void draw_char(const Band *b, int x, int y, char c, uint32_t color) {
+    int index = font_index(c);
+    if (index < 0) return;
 
     for (int row = 0; row < 8; row++) {
         uint8_t line = font[index][row];
@@ -425,7 +1082,7 @@ static void draw_char(int x, int y, char c, uint32_t color) {
             if (line & (0x80 >> col)) {
                 int px = x + col * 2;
                 int py = y + row * 2;
-                draw_rect(px, py, 2, 2, color);
+                draw_rect(b, px, py, 2, 2, color);
             }
         }
     }
@@ -433,79 +1090,83 @@ static void draw_char(int x, int y, char c, uint32_t color) {
 
 
 // 绘制分数（优化后更圆滑的字体）
-static void draw_score() {
-    // 主分数
-    char score_str[10];
-    snprintf(score_str, sizeof(score_str), "%d", game.score + game.coin_score);
-    int len = strlen(score_str);
-    int char_size = 16;  // 匹配增大的字符尺寸
+// 分数栏排版（字符16像素见方，从y=10开始）
+#define SCORE_Y 10
+#define CHAR_SIZE 16  // 匹配增大的字符尺寸
+
+typedef struct {
+    char score[10];  // 主分数，绘制在屏幕顶部中央
+    char coin[12];   // 有金币分数时在主分数左侧显示金币图标和额外分数，否则为空串
+    int score_x, coin_x, icon_x;
+} ScoreLayout;
+
+static void layout_score(ScoreLayout *l) {
+    snprintf(l->score, sizeof(l->score), "%d", game.score + game.coin_score);
+    l->score_x = game.screen_width/2 - ((int)strlen(l->score) * CHAR_SIZE) / 2;
+    l->coin[0] = '\0';
+    if (game.coin_score > 0) {
+        snprintf(l->coin, sizeof(l->coin), "+%d", game.coin_score);
+        l->icon_x = l->score_x - CHAR_SIZE;
+        l->coin_x = l->icon_x - (int)strlen(l->coin) * CHAR_SIZE;
+    }
+}
 
-    // 绘制在屏幕顶部中央
-    int start_x = game.screen_width/2 - (len * char_size) / 2;
-    for (int i = 0; i < len; i++) {
-        draw_char(start_x + i * char_size, 10, score_str[i], COLOR_SCORE);
+static void draw_score(const Band *b) {
+    ScoreLayout l;
+    layout_score(&l);
+    for (int i = 0; l.score[i]; i++) {
+        draw_char(b, l.score_x + i * CHAR_SIZE, SCORE_Y, l.score[i], COLOR_SCORE);
     }
 
-    // 如果有金币分数，显示金币图标和额外分数
-    if (game.coin_score > 0) {
-        char coin_str[5];
-        snprintf(coin_str, sizeof(coin_str), "+%d", game.coin_score);
-        int coin_len = strlen(coin_str);
-        
+    if (l.coin[0]) {
         // 绘制金币小图标
-        int coin_icon_x = start_x - char_size;
-        int coin_icon_y = 10;
-        for (int dy = -4; dy <= 4; dy++) {
-            for (int dx = -4; dx <= 4; dx++) {
-                if (dx*dx + dy*dy <= 16) {  // 4x4的小圆
-                    frame_buf_set_pixel(coin_icon_x + 8 + dx, coin_icon_y + 8 + dy, COLOR_COIN);
-                }
-            }
-        }
+        draw_spans(b, &coin_icon_spans, l.icon_x + 8, SCORE_Y + 8, COLOR_COIN);
         
         // 绘制额外分数
-        for (int i = 0; i < coin_len; i++) {
-            draw_char(coin_icon_x - coin_len * char_size + i * char_size, 10, coin_str[i], COLOR_COIN);
+        for (int i = 0; l.coin[i]; i++) {
+            draw_char(b, l.coin_x + i * CHAR_SIZE, SCORE_Y, l.coin[i], COLOR_COIN);
         }
     }
 }
 
 // 检测金币碰撞（小鸟是否吃到金币）
-static void check_coin_collision() {
-    int bird_x = game.screen_width / 4;
-    int bird_y = game.bird_y / SCALE;  // 转换为实际坐标
+// 小鸟（掩码 m，y 坐标 bird_y）与金币的碰撞，金币比当前位置靠右 shift 像素
+static void check_coin_collision(const Mask *m, int bird_y, int shift) {
+    int bird_x = BIRD_X(game.screen_width);
     
-    for (int i = 0; i < 10; i++) {
-        Coin *c = &game.coins[i];
-        if (!c->active || c->collected) continue;
-        
-        // 计算小鸟和金币的距离
-        int dx = c->x - bird_x;
-        int dy = c->y - bird_y;
-        int min_dist = (game.bird_size + c->size) / 3;  // 碰撞距离阈值
-        
-        if (dx*dx + dy*dy <= min_dist*min_dist) {
-            // 吃到金币，加分并标记为已收集
-            c->collected = true;
+    CoinPool *c = &game.coins;
+    for (int i = c->count - 1; i >= 0; i--) {
+        // 小鸟和金币的像素有重叠
+        if (masks_overlap(m, bird_x, bird_y, &coin_mask, c->x[i] + shift, c->y[i])) {
+            // 吃到金币，加分、迸出金色粒子并移出金币池
             game.coin_score += 1;  // 每个金币加1分
+            particle_burst(c->x[i] + shift, c->y[i], COIN_BURST, 300, 250, -game.pipe_speed * SCALE,
+                           COLOR_COIN, COLOR_COIN_BORDER);
+            remove_coin(i);
         }
     }
 }
 
+// 整屏变暗到约30%亮度：R和B通道放在同一个字里一起乘，G单独乘，
+// 乘77再右移8位近似乘0.3，每像素两次乘法、没有除法
+static void darken_frame() {
+    uint32_t *p = game.frame_buf;
+    uint32_t *end = p + game.fb_width * game.fb_height;
+    for (; p < end; p++) {
+        uint32_t c = *p;
+        uint32_t rb = (((c & 0x00FF00FF) * 77) >> 8) & 0x00FF00FF;
+        uint32_t g  = (((c & 0x0000FF00) * 77) >> 8) & 0x0000FF00;
+        *p = 0xFF000000 | rb | g;
+    }
+}
+
 static void draw_game_over() {
     // 半透明遮罩
-    for (int y = 0; y < game.screen_height; y++) {
-        for (int x = 0; x < game.screen_width; x++) {
-            uint32_t original = game.frame_buf[y * game.screen_width + x];
-            uint32_t r = (original >> 16) & 0xFF;
-            uint32_t g = (original >> 8) & 0xFF;
-            uint32_t b = original & 0xFF;
-            r = (r * 3) / 10;
-            g = (g * 3) / 10;
-            b = (b * 3) / 10;
-            frame_buf_set_pixel(x, y, (0xFF << 24) | (r << 16) | (g << 8) | b);
-        }
-    }
+    darken_frame();
+
+    // 只在单核上合成一次，裁剪带为整屏
+    Band full = { 0, game.fb_height };
+    const Band *b = &full;
 
     int char_width = 16; // 每个字符宽度（放大后）
 
@@ -515,7 +1176,7 @@ static void draw_game_over() {
     int msg_x = (game.screen_width - msg_len * char_width) / 2;
     int msg_y = game.screen_height / 2 - 30;
     for (int i = 0; i < msg_len; i++) {
-        draw_char(msg_x + i * char_width, msg_y, msg[i], COLOR_RED);
+        draw_char(b, msg_x + i * char_width, msg_y, msg[i], COLOR_RED);
     }
 
     // 绘制“SCORE: X”
@@ -525,7 +1186,7 @@ static void draw_game_over() {
     int score_x = (game.screen_width - score_len * char_width) / 2;
     int score_y = game.screen_height / 2 + 20;
     for (int i = 0; i < score_len; i++) {
-        draw_char(score_x + i * char_width, score_y, score_str[i], COLOR_SCORE);
+        draw_char(b, score_x + i * char_width, score_y, score_str[i], COLOR_SCORE);
     }
 
     // 绘制“PRESS R”
@@ -534,50 +1195,91 @@ static void draw_game_over() {
     int hint_x = (game.screen_width - hint_len * char_width) / 2;
     int hint_y = game.screen_height / 2 + 60;
     for (int i = 0; i < hint_len; i++) {
-        draw_char(hint_x + i * char_width, hint_y, hint[i], COLOR_TEXT);
+        draw_char(b, hint_x + i * char_width, hint_y, hint[i], COLOR_TEXT);
     }
 }
 
 
-// 检测碰撞
-static bool check_collision() {
-    int bird_x = game.screen_width / 4;
-    int bird_y = game.bird_y / SCALE;  // 转换为实际坐标
+// 检测碰撞：小鸟（掩码 m，y 坐标 bird_y）与地面、顶部和管道，管道比当前位置靠右 shift 像素
+static bool check_collision(const Mask *m, int bird_y, int shift) {
+    int bird_x = BIRD_X(game.screen_width);
+    int ground_y = game.screen_height - game.ground_height;
     
     // 检测地面碰撞
-    if (bird_y + game.bird_size/2 >= game.screen_height - game.ground_height) return true;
+    if (bird_y + m->y1 > ground_y) return true;
     // 检测顶部碰撞
-    if (bird_y - game.bird_size/2 <= 0) return true;
+    if (bird_y + m->y0 < 0) return true;
+
+    // 检测管道碰撞：从小鸟前方第一个管道开始（刚计分的管道口可能还挨着尾巴，也查一下），
+    // 到左边缘越过小鸟右侧为止，实际最多检查两三个
+    int first = game.pipe_ahead > 0 ? game.pipe_ahead - 1 : 0;
+    for (int i = first; i < game.pipe_count; i++) {
+        Pipe *p = pipe_at(i);
+        int x = p->x + shift;
+        if (x - PIPE_LIP_OVERHANG >= bird_x + m->x1) break;
+
+        // 与绘制相同的四块：上管身、上管口、下管口、下管身
+        int lip_x = x - PIPE_LIP_OVERHANG, lip_w = game.pipe_width + 2 * PIPE_LIP_OVERHANG;
+        int gap_top = p->gap_y - game.pipe_gap/2;
+        int gap_bottom = p->gap_y + game.pipe_gap/2;
+        if (mask_hits_rect(m, bird_x, bird_y, x, 0, game.pipe_width, gap_top)) return true;
+        if (mask_hits_rect(m, bird_x, bird_y, lip_x, gap_top, lip_w, PIPE_LIP_HEIGHT)) return true;
+        if (mask_hits_rect(m, bird_x, bird_y, lip_x, gap_bottom - PIPE_LIP_HEIGHT, lip_w, PIPE_LIP_HEIGHT)) return true;
+        if (mask_hits_rect(m, bird_x, bird_y, x, gap_bottom, game.pipe_width, ground_y - gap_bottom)) return true;
+    }
+    return false;
+}
 
-    // 检测管道碰撞
-    for (int i = 0; i < 5; i++) {
-        Pipe *p = &game.pipes[i];
-        if (!p->active) continue;
-        
-        // 管道与小鸟x范围重叠
-        if (p->x <= bird_x + game.bird_size/2 && p->x + game.pipe_width >= bird_x - game.bird_size/2) {
-            // 检测上管道碰撞
-            if (bird_y - game.bird_size/2 <= p->gap_y - game.pipe_gap/2) return true;
-            // 检测下管道碰撞
-            if (bird_y + game.bird_size/2 >= p->gap_y + game.pipe_gap/2) return true;
+// 把管道和金币整体右移 shift 像素，撞上时用来退回到接触点
+static void shift_world(int shift) {
+    for (int i = 0; i < game.pipe_count; i++) {
+        pipe_at(i)->x += shift;
+    }
+    for (int i = 0; i < game.coins.count; i++) {
+        game.coins.x[i] += shift;
+    }
+}
+
+// 扫掠碰撞：从本步开始时的小鸟状态 (y, v) 出发，按基础步逐步重算位置，每个基础步内
+// 小鸟相对管道的运动路径再按不超过1像素细分，逐点检测金币和碰撞。这样小鸟快速运动或
+// 降低物理频率时也不会穿过管道口。撞上时把小鸟、管道和金币退回到接触点并返回 true
+static bool sweep_collision(int y, int v) {
+    for (int j = 1; j <= PHYSICS_DIV; j++) {
+        v += GRAVITY;
+        int ny = y + v;
+        const Mask *m = &bird_masks[bird_angle_of(v)];
+        int y0 = y / SCALE, dy = ny / SCALE - y0;
+        int n = dy < 0 ? -dy : dy;
+        if (n < game.pipe_speed) n = game.pipe_speed;
+        if (n < 1) n = 1;
+        for (int s = 1; s <= n; s++) {
+            int py = y0 + dy * s / n;
+            // 这一点上管道和金币比本步结束时靠右的距离
+            int shift = ((PHYSICS_DIV - j) * n + (n - s)) * game.pipe_speed / n;
+            check_coin_collision(m, py, shift);
+            if (check_collision(m, py, shift)) {
+                game.bird_y = py * SCALE;
+                game.velocity = v;
+                shift_world(shift);
+                return true;
+            }
         }
+        y = ny;
     }
     return false;
 }
 
 // 更新分数
 static void update_score() {
-    int bird_x = game.screen_width / 4;
-    for (int i = 0; i < 5; i++) {
-        Pipe *p = &game.pipes[i];
-        // 只对活动且未计分的管道进行判断
-        if (!p->active || p->passed) continue;
+    int bird_x = BIRD_X(game.screen_width);
+    // 管道按x排列，只需看小鸟前方的第一个
+    while (game.pipe_ahead < game.pipe_count) {
+        Pipe *p = pipe_at(game.pipe_ahead);
         
         // 小鸟完全穿过管道
-        if (p->x + game.pipe_width < bird_x - game.bird_size/2) {
-            game.score++;
-            p->passed = true;
-        }
+        if (p->x + game.pipe_width >= bird_x - game.bird_size/2) break;
+        game.score++;
+        game.pipe_ahead++;
     }
 }
 
@@ -600,69 +1302,727 @@ static void handle_input() {
     }
 }
 
-// 更新游戏状态
+// 更新游戏状态（一个物理步）
 static void update_game() {
+    // 记录上一步的状态，用于渲染插值
+    game.prev_bird_y = game.bird_y;
+    for (int i = 0; i < NR_LAYERS; i++) {
+        layers[i].prev_pos = layers[i].pos;
+    }
+    for (int i = 0; i < game.pipe_count; i++) {
+        pipe_at(i)->prev_x = pipe_at(i)->x;
+    }
+    for (int i = 0; i < game.coins.count; i++) {
+        game.coins.prev_x[i] = game.coins.x[i];
+    }
+
+    // 粒子在游戏结束后也继续运动，把撞毁的效果播完
+    update_particles();
+
     if (game.state != GAME_RUNNING) return;
 
-    // 更新小鸟位置（使用整数运算模拟浮点）
-    game.velocity += GRAVITY;
-    game.bird_y += game.velocity;
+    // 更新小鸟位置（使用整数运算模拟浮点）：每个基础步先加重力再移动，k 步合起来
+    // 位移为 k*v + G*k(k+1)/2
+    const int k = PHYSICS_DIV;
+    int start_y = game.bird_y, start_v = game.velocity;
+    game.bird_y += k * game.velocity + GRAVITY * k * (k + 1) / 2;
+    game.velocity += k * GRAVITY;
 
     // 更新管道和金币
     update_pipes_and_coins();
 
+    // 背景层滚动
+    scroll_layers();
+
+    // 沿本步的运动路径检测金币和管道/边界碰撞。撞上时管道已经退回到接触点，
+    // 本步不再计分：在接触点之后才穿过的管道不算
+    if (sweep_collision(start_y, start_v)) {
+        game.state = GAME_OVER;
+        particle_burst(BIRD_X(game.screen_width), game.bird_y / SCALE, CRASH_BURST, 500, 600, 0,
+                       COLOR_BIRD, COLOR_WING);
+        return;
+    }
+
     // 更新分数
     update_score();
+}
 
-    // 检测金币碰撞
-    check_coin_collision();
+// 根据各元素上一帧和本帧的位置记录脏矩形
+static void track_damage() {
+    // 游戏结束遮罩覆盖整个屏幕
+    if (game.game_over_drawn) {
+        game.full_redraw = true;
+    }
 
-    // 检测管道/边界碰撞
-    if (check_collision()) {
-        game.state = GAME_OVER;
+    // 小鸟：旧位置和新位置
+    int bird_x = BIRD_X(game.screen_width);
+    int bird_y = bird_render_y();
+    int r = bird_sprite_r;
+    if (game.bird_drawn) {
+        mark_dirty_moved(bird_x - r, game.drawn_bird_y - r, bird_x - r, bird_y - r, 2 * r + 1, 2 * r + 1);
+    } else {
+        mark_dirty(bird_x - r, bird_y - r, 2 * r + 1, 2 * r + 1);
+    }
+    game.bird_drawn = true;
+    game.drawn_bird_y = bird_y;
+
+    // 管道：主体是纯色，移动时只有左右两条边缘发生变化
+    int play_height = game.screen_height - game.ground_height;
+    for (int i = 0; i < game.pipe_count; i++) {
+        Pipe *p = pipe_at(i);
+        int x = pipe_render_x(p);
+        bool visible = x <= game.screen_width && x + game.pipe_width >= 0;
+        if (!visible) {
+            erase_pipe(p);
+            continue;
+        }
+        if (!p->drawn) {
+            mark_pipe_dirty(x);
+        } else if (p->drawn_x != x) {
+            int x0 = p->drawn_x < x ? p->drawn_x : x;
+            int x1 = p->drawn_x < x ? x : p->drawn_x;
+            mark_dirty(x0 - PIPE_LIP_OVERHANG, 0, x1 - x0 + PIPE_LIP_OVERHANG, play_height);  // 左边缘
+            mark_dirty(x0 + game.pipe_width, 0, x1 - x0 + PIPE_LIP_OVERHANG, play_height);  // 右边缘
+        }
+        p->drawn = true;
+        p->drawn_x = x;
+    }
+
+    // 金币：旧位置和新位置
+    CoinPool *c = &game.coins;
+    int cr = game.coin_size / 2;
+    for (int i = 0; i < c->count; i++) {
+        int x = coin_render_x(i);
+        bool visible = x <= game.screen_width && x + game.coin_size >= 0;
+        if (!visible) {
+            erase_coin(i);
+            continue;
+        }
+        if (c->drawn[i]) {
+            mark_dirty_moved(c->drawn_x[i] - cr, c->drawn_y[i] - cr, x - cr, c->y[i] - cr, 2 * cr + 1, 2 * cr + 1);
+        } else {
+            mark_coin_dirty(x, c->y[i], game.coin_size);
+        }
+        c->drawn[i] = true;
+        c->drawn_x[i] = x;
+        c->drawn_y[i] = c->y[i];
+    }
+
+    // 粒子：数量多，只记录旧的和新的包围盒
+    if (particles_drawn) {
+        mark_dirty(drawn_particles.x, drawn_particles.y, drawn_particles.w, drawn_particles.h);
+    }
+    particles_drawn = particles.count > 0;
+    if (particles_drawn) {
+        int x0 = game.screen_width, y0 = game.screen_height, x1 = 0, y1 = 0;
+        for (int k = 0; k < particles.count; k++) {
+            int i = (particles.head + k) & (MAX_PARTICLES - 1);
+            int x = particle_render_x(i), y = particle_render_y(i);
+            x0 = x < x0 ? x : x0;
+            x1 = x > x1 ? x : x1;
+            y0 = y < y0 ? y : y0;
+            y1 = y > y1 ? y : y1;
+        }
+        int pr = ((PARTICLE_SIZES - 1) << RENDER_SHIFT) + RENDER_SCALE;  // 圆点半径（屏幕坐标）
+        drawn_particles = (Rect){ x0 - pr, y0 - pr, x1 - x0 + 2 * pr + 1, y1 - y0 + 2 * pr + 1 };
+        mark_dirty(drawn_particles.x, drawn_particles.y, drawn_particles.w, drawn_particles.h);
+    }
+
+    // 背景层：偏移变了就整条重新上传
+    for (int i = 0; i < NR_LAYERS; i++) {
+        Layer *l = &layers[i];
+        int offset = layer_render_offset(l);
+        if (offset != l->drawn_offset) {
+            mark_dirty(0, l->y << RENDER_SHIFT, game.screen_width, l->h << RENDER_SHIFT);
+            l->drawn_offset = offset;
+        }
+    }
+
+    // 分数变化时更新顶部分数栏
+    int total = game.score + game.coin_score;
+    if (total != game.drawn_score || game.coin_score != game.drawn_coin_score) {
+        mark_dirty(0, SCORE_Y, game.screen_width, CHAR_SIZE);
+        game.drawn_score = total;
+        game.drawn_coin_score = game.coin_score;
+    }
+}
+
+#if RENDER_SHIFT > 0
+// 把缓冲区中 [x0, x1) x [y0, y1) 的区域放大后上传：每行先横向把每个像素复制 RENDER_SCALE 份，
+// 再整行复制出 RENDER_SCALE 行，一次上传
+static void present_scaled(int x0, int y0, int x1, int y1) {
+    int sx = x0 << RENDER_SHIFT;
+    int sw = ((x1 << RENDER_SHIFT) > game.screen_width ? game.screen_width : (x1 << RENDER_SHIFT)) - sx;
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *src = game.frame_buf + y * game.fb_width + x0;
+        uint32_t *dst = scale_buf;
+        for (int x = x0; x < x1; x++) {
+            uint32_t c = *src++;
+            for (int k = 0; k < RENDER_SCALE; k++) *dst++ = c;
+        }
+        int sy = y << RENDER_SHIFT;
+        int sh = (sy + RENDER_SCALE > game.screen_height) ? game.screen_height - sy : RENDER_SCALE;
+        for (int k = 1; k < sh; k++) {
+            copy_row(scale_buf + k * sw, scale_buf, sw);
+        }
+        io_write(AM_GPU_FBDRAW, sx, sy, scale_buf, sw, sh, false);
+    }
+}
+
+// 把本帧的脏矩形换算到缓冲区坐标后放大上传
+static void present_frame() {
+    if (game.full_redraw) {
+        present_scaled(0, 0, game.fb_width, game.fb_height);
+    } else {
+        for (int i = 0; i < game.dirty_count; i++) {
+            Rect *r = &game.dirty[i];
+            present_scaled(TO_FB(r->x), TO_FB(r->y), TO_FB_END(r->x + r->w), TO_FB_END(r->y + r->h));
+        }
+    }
+    io_write(AM_GPU_FBDRAW, 0, 0, NULL, 0, 0, true);
+    game.dirty_count = 0;
+    game.full_redraw = false;
+}
+#else
+// 把本帧的脏矩形上传到屏幕
+static void present_frame() {
+    if (game.full_redraw) {
+        io_write(AM_GPU_FBDRAW, 0, 0, game.frame_buf, game.screen_width, game.screen_height, true);
+    } else {
+        for (int i = 0; i < game.dirty_count; i++) {
+            Rect *r = &game.dirty[i];
+            uint32_t *src = game.frame_buf + r->y * game.screen_width + r->x;
+            if (r->w == game.screen_width) {
+                // 整行宽的区域在缓冲区中是连续的，一次上传
+                io_write(AM_GPU_FBDRAW, 0, r->y, src, r->w, r->h, false);
+            } else {
+                for (int j = 0; j < r->h; j++) {
+                    io_write(AM_GPU_FBDRAW, r->x, r->y + j, src + j * game.screen_width, r->w, 1, false);
+                }
+            }
+        }
+        io_write(AM_GPU_FBDRAW, 0, 0, NULL, 0, 0, true);
+    }
+    game.dirty_count = 0;
+    game.full_redraw = false;
+}
+#endif
+
+// 画家算法合成一条水平带：天空和远景、管道、金币、地面、小鸟、粒子、分数（按层次从后往前绘制）
+static void render_band_painter(const Band *b) {
+    draw_background(b);
+    draw_pipes(b);
+    draw_coins(b);
+    draw_ground(b);
+    draw_bird(b);
+    draw_particles(b);
+    draw_score(b);
+}
+
+#if defined(SPAN_RENDER) || defined(BENCH)
+// 扫描线渲染：逐行按从前往后的顺序（分数、粒子、小鸟、地面、金币、管道）取出各元素在这一行的
+// 水平跨度，用按x排序的已覆盖区间表裁掉被前面元素挡住的部分，只写露出来的像素，
+// 最后用远景层或天空色填满剩下的空隙。每个像素每帧只写一次，结果与画家算法逐像素相同
+#define MAX_COVER 1024  // 已覆盖区间互不相邻，缓冲区宽度不超过 2*MAX_COVER-2 时不会溢出
+#define PARTICLE_ROWS (2 * TO_FB(PARTICLE_SIZES - 1) + 1)  // 粒子圆点最多占的行数
+
+typedef struct {
+    int16_t x0, x1;
+} Cover;
+
+typedef struct {
+    uint32_t *row;          // 帧缓冲中正在画的一行
+    int n;                  // 已覆盖区间数
+    Cover c[MAX_COVER];     // 按x排序，互不重叠也不相邻
+} ScanRow;
+
+// 跨度的像素来源：src 非空时第 x 列取 src[x + dx]，否则填 color
+typedef struct {
+    const uint32_t *src;
+    int dx;
+    uint32_t color;
+} Paint;
+
+static void paint(ScanRow *r, int x0, int x1, const Paint *p) {
+    if (p->src) copy_row(r->row + x0, p->src + x0 + p->dx, x1 - x0);
+    else fill_row(r->row + x0, x1 - x0, p->color);
+}
+
+// 写 [x0, x1) 中还没被覆盖的部分，再把整段并入已覆盖区间表
+static void scan_span(ScanRow *r, int x0, int x1, const Paint *p) {
+    if (x0 < 0) x0 = 0;
+    if (x1 > game.fb_width) x1 = game.fb_width;
+    if (x1 <= x0) return;
+
+    // 二分找到第一个与 [x0, x1) 重叠或相邻的区间
+    int i = 0, hi_i = r->n;
+    while (i < hi_i) {
+        int mid = (i + hi_i) / 2;
+        if (r->c[mid].x1 < x0) i = mid + 1;
+        else hi_i = mid;
     }
+    int j = i, x = x0, lo = x0, hi = x1;
+    for (; j < r->n && r->c[j].x0 <= x1; j++) {
+        if (r->c[j].x0 > x) paint(r, x, r->c[j].x0, p);
+        if (r->c[j].x1 > x) x = r->c[j].x1;
+        if (r->c[j].x0 < lo) lo = r->c[j].x0;
+        if (r->c[j].x1 > hi) hi = r->c[j].x1;
+    }
+    if (x < x1) paint(r, x, x1, p);
+
+    // 区间 i..j-1 与新跨度合并成一个
+    if (j == i) {
+        memmove(&r->c[i + 1], &r->c[i], (r->n - i) * sizeof(Cover));
+        r->n++;
+    } else if (j > i + 1) {
+        memmove(&r->c[i + 1], &r->c[j], (r->n - j) * sizeof(Cover));
+        r->n -= j - i - 1;
+    }
+    r->c[i] = (Cover){ lo, hi };
 }
 
+static void scan_color(ScanRow *r, int x0, int x1, uint32_t color) {
+    Paint p = { NULL, 0, color };
+    scan_span(r, x0, x1, &p);
+}
+
+// 与 draw_rect 相同的换算和裁剪，只取第 y 行
+static void scan_rect(ScanRow *r, int y, int x, int ry, int w, int h, uint32_t color) {
+    if (y < TO_FB(ry) || y >= TO_FB_END(ry + h)) return;
+    scan_color(r, TO_FB(x), TO_FB_END(x + w), color);
+}
+
+// 与 draw_spans 相同，只取第 y 行
+static void scan_spans(ScanRow *r, int y, const Spans *s, int cx, int cy, uint32_t color) {
+    int i = y - (TO_FB(cy) + s->top);
+    if (i < 0 || i >= s->rows) return;
+    cx = TO_FB(cx);
+    scan_color(r, cx + s->x0[i], cx + s->x1[i], color);
+}
+
+// 与 draw_sprite 相同，只取第 y 行
+static void scan_sprite(ScanRow *r, int y, const Sprite *sp, int cx, int cy) {
+    int i = y - (TO_FB(cy) + sp->top);
+    if (i < 0 || i >= sp->rows) return;
+    cx = TO_FB(cx);
+    for (int k = sp->row_start[i]; k < sp->row_start[i + 1]; k++) {
+        scan_color(r, cx + sp->runs[k].x, cx + sp->runs[k].x + sp->runs[k].len, sp->runs[k].color);
+    }
+}
+
+// 与 draw_char 相同（每个点是一个 2x2 的 draw_rect），只取第 y 行
+static void scan_char(ScanRow *r, int y, int x, int cy, char c, uint32_t color) {
+    int index = font_index(c);
+    if (index < 0) return;
+    for (int row = 0; row < 8; row++) {
+        uint8_t line = font[index][row];
+        if (!line || y < TO_FB(cy + row * 2) || y >= TO_FB_END(cy + row * 2 + 2)) continue;
+        for (int col = 0; col < 8; col++) {
+            if (line & (0x80 >> col)) {
+                scan_color(r, TO_FB(x + col * 2), TO_FB_END(x + col * 2 + 2), color);
+            }
+        }
+    }
+}
+
+// 整行的背景层（与 draw_layer 相同，横向首尾回绕）
+static void scan_layer(ScanRow *r, int y, const Layer *l, int offset) {
+    if (y < l->y || y >= l->y + l->h) return;
+    const uint32_t *src = l->pix + (y - l->y) * game.fb_width;
+    Paint head = { src, offset, 0 };
+    Paint tail = { src, offset - game.fb_width, 0 };
+    scan_span(r, 0, game.fb_width - offset, &head);
+    scan_span(r, game.fb_width - offset, game.fb_width, &tail);
+}
+
+// 这一行上的粒子：从首行可能覆盖到这一行的几个桶里按新到旧归并（画家算法中新的在上面）
+static void scan_particles(ScanRow *r, int y) {
+    int pos[PARTICLE_ROWS], end[PARTICLE_ROWS], nb = 0;
+    for (int t = (y - PARTICLE_ROWS + 1 > 0 ? y - PARTICLE_ROWS + 1 : 0); t <= y; t++) {
+        if (span_particles.bucket[t] < span_particles.bucket[t + 1]) {
+            pos[nb] = span_particles.bucket[t];
+            end[nb++] = span_particles.bucket[t + 1];
+        }
+    }
+    while (1) {
+        int best = -1;
+        for (int k = 0; k < nb; k++) {
+            if (pos[k] < end[k] &&
+                (best < 0 || span_particles.order[pos[k]] > span_particles.order[pos[best]])) best = k;
+        }
+        if (best < 0) break;
+        int i = (particles.head + span_particles.order[pos[best]++]) & (MAX_PARTICLES - 1);
+        const Spans *s = &particle_spans[span_particles.size[i]];
+        int row = y - span_particles.top[i];
+        if (row < s->rows) {
+            int cx = span_particles.x[i];
+            scan_color(r, cx + s->x0[row], cx + s->x1[row], particles.color[i]);
+        }
+    }
+}
+
+// 每帧一次：算出各粒子的绘制位置，按首行计数排序（从新到旧放入，桶内保持新的在前）
+static void prepare_spans() {
+    int H = game.fb_height;
+    int *bucket = span_particles.bucket;
+    memset(bucket, 0, (H + 1) * sizeof(int));
+    for (int k = particles.count - 1; k >= 0; k--) {
+        int i = (particles.head + k) & (MAX_PARTICLES - 1);
+        int size = (particles.tick - particles.born[i]) * PARTICLE_SIZES / PARTICLE_TICKS;
+        int top = TO_FB(particle_render_y(i)) + particle_spans[size].top;
+        span_particles.x[i] = TO_FB(particle_render_x(i));
+        span_particles.top[i] = top;
+        span_particles.size[i] = size;
+        if (top >= H || top + particle_spans[size].rows <= 0) continue;  // 整个在屏幕外
+        bucket[(top > 0 ? top : 0) + 1]++;
+    }
+    for (int y = 0; y < H; y++) {
+        bucket[y + 1] += bucket[y];
+    }
+    // 借用 bucket[y] 作为填充游标，填完后 bucket[y] 恰好变成第 y+1 桶的起点，再整体后移一格
+    for (int k = particles.count - 1; k >= 0; k--) {
+        int i = (particles.head + k) & (MAX_PARTICLES - 1);
+        int top = span_particles.top[i];
+        if (top >= H || top + particle_spans[span_particles.size[i]].rows <= 0) continue;
+        span_particles.order[bucket[top > 0 ? top : 0]++] = k;
+    }
+    memmove(bucket + 1, bucket, H * sizeof(int));
+    bucket[0] = 0;
+}
+
+// 扫描线合成一条水平带，层次与 render_band_painter 相同
+static void render_band_spans(const Band *b) {
+    ScanRow r;
+    ScoreLayout score;
+    layout_score(&score);
+    int score_len = strlen(score.score), coin_len = strlen(score.coin);
+
+    int bird_x = BIRD_X(game.screen_width);
+    int bird_y = bird_render_y();
+    const Sprite *bird = &bird_sprites[bird_angle()];
+
+    // 可见的管道和金币（剔除条件与 draw_pipes、draw_coins 相同），按从前往后排列
+    int pipe_x[MAX_PIPES], pipe_idx[MAX_PIPES], np = 0;
+    for (int i = game.pipe_count - 1; i >= 0; i--) {
+        int x = pipe_render_x(pipe_at(i));
+        if (x > game.screen_width || x + game.pipe_width < 0) continue;
+        pipe_idx[np] = i;
+        pipe_x[np++] = x;
+    }
+    int coin_x[MAX_COINS], coin_idx[MAX_COINS], nc = 0;
+    for (int i = game.coins.count - 1; i >= 0; i--) {
+        int x = coin_render_x(i);
+        if (x > game.screen_width || x + game.coin_size < 0) continue;
+        coin_idx[nc] = i;
+        coin_x[nc++] = x;
+    }
+
+    const Layer *clouds = &layers[LAYER_CLOUDS];
+    const Layer *skyline = &layers[LAYER_SKYLINE];
+    const Layer *ground = &layers[LAYER_GROUND];
+    int clouds_offset = layer_render_offset(clouds);
+    int skyline_offset = layer_render_offset(skyline);
+    int ground_offset = layer_render_offset(ground);
+    int play_height = game.screen_height - game.ground_height;
+
+    for (int y = b->y0; y < b->y1; y++) {
+        r.row = game.frame_buf + y * game.fb_width;
+        r.n = 0;
+
+        // 分数栏（draw_score 中后画的在前）
+        if (y < TO_FB_END(SCORE_Y + CHAR_SIZE)) {
+            for (int i = coin_len - 1; i >= 0; i--) {
+                scan_char(&r, y, score.coin_x + i * CHAR_SIZE, SCORE_Y, score.coin[i], COLOR_COIN);
+            }
+            if (coin_len > 0) scan_spans(&r, y, &coin_icon_spans, score.icon_x + 8, SCORE_Y + 8, COLOR_COIN);
+            for (int i = score_len - 1; i >= 0; i--) {
+                scan_char(&r, y, score.score_x + i * CHAR_SIZE, SCORE_Y, score.score[i], COLOR_SCORE);
+            }
+        }
+
+        scan_particles(&r, y);
+        scan_sprite(&r, y, bird, bird_x, bird_y);
+        scan_layer(&r, y, ground, ground_offset);
+
+        for (int k = 0; k < nc; k++) {
+            int cy = game.coins.y[coin_idx[k]];
+            scan_spans(&r, y, &coin_inner_spans, coin_x[k], cy, COLOR_COIN);
+            scan_spans(&r, y, &coin_outer_spans, coin_x[k], cy, COLOR_COIN_BORDER);
+        }
+
+        for (int k = 0; k < np; k++) {
+            Pipe *p = pipe_at(pipe_idx[k]);
+            int x = pipe_x[k];
+            int lip_x = x - PIPE_LIP_OVERHANG, lip_w = game.pipe_width + 2 * PIPE_LIP_OVERHANG;
+            int gap_top = p->gap_y - game.pipe_gap/2;
+            int gap_bottom = p->gap_y + game.pipe_gap/2;
+            scan_rect(&r, y, lip_x, gap_bottom - PIPE_LIP_HEIGHT, lip_w, PIPE_LIP_HEIGHT, COLOR_PIPE_TOP);
+            scan_rect(&r, y, x, gap_bottom, game.pipe_width, play_height - gap_bottom, COLOR_PIPE);
+            scan_rect(&r, y, lip_x, gap_top, lip_w, PIPE_LIP_HEIGHT, COLOR_PIPE_TOP);
+            scan_rect(&r, y, x, 0, game.pipe_width, gap_top, COLOR_PIPE);
+        }
+
+        // 背景：与 draw_background 相同的分段
+        scan_layer(&r, y, skyline, skyline_offset);
+        scan_layer(&r, y, clouds, clouds_offset);
+        if (y < clouds->y || (y >= clouds->y + clouds->h && y < skyline->y)) {
+            scan_color(&r, 0, game.fb_width, COLOR_BG);
+        }
+    }
+}
+#endif
+
+// 渲染前的准备（只在0号核上执行）
+static void prepare_frame() {
+#ifdef SPAN_RENDER
+    prepare_spans();
+#endif
+}
+
+// 合成一条水平带，渲染方式在编译时选择（SPAN_RENDER）
+static void render_band(const Band *b) {
+#ifdef SPAN_RENDER
+    // 已覆盖区间表放不下特别宽的缓冲区，这时退回画家算法
+    if (game.fb_width <= 2 * MAX_COVER - 2) {
+        render_band_spans(b);
+        return;
+    }
+#endif
+    render_band_painter(b);
+}
+
+// 第i条（共n条）水平带的范围
+static void band_of(int i, int n, Band *b) {
+    b->y0 = game.fb_height * i / n;
+    b->y1 = game.fb_height * (i + 1) / n;
+}
+
+#ifdef MPE
+// 多核渲染：0号核负责输入、物理和上传，每帧发布新的帧序号后和其它核各画一条带，
+// 再等所有核报告完成这一帧（逐帧屏障）。像素循环里没有任何锁，
+// 各核只写自己那条带；0号核在屏障之后才会修改游戏状态
+#define MAX_HARTS 8
+static volatile int frame_seq;             // 0号核发布的帧序号
+static volatile int band_done[MAX_HARTS];  // 各核已完成的帧序号
+static int nr_bands = 1;
+
+static void render_frame() {
+    prepare_frame();
+    int seq = frame_seq + 1;
+    __sync_synchronize();
+    atomic_xchg((int *)&frame_seq, seq);
+
+    Band b;
+    band_of(0, nr_bands, &b);
+    render_band(&b);
+
+    for (int i = 1; i < nr_bands; i++) {
+        while (band_done[i] != seq) ;
+    }
+    __sync_synchronize();
+}
+
+// 其它核：等待新帧，画自己的带，报告完成
+static void render_worker(int id) {
+    int seen = 0;
+    while (1) {
+        int seq;
+        while ((seq = frame_seq) == seen) ;
+        __sync_synchronize();
+
+        Band b;
+        band_of(id, nr_bands, &b);
+        render_band(&b);
+
+        __sync_synchronize();
+        atomic_xchg((int *)&band_done[id], seq);
+        seen = seq;
+    }
+}
+#else
+static void render_frame() {
+    prepare_frame();
+    Band b;
+    band_of(0, 1, &b);
+    render_band(&b);
+}
+#endif
+
 // 绘制游戏画面
 static void draw_game() {
-    // 清空缓冲区（绘制背景）
-    draw_rect(0, 0, game.screen_width, game.screen_height, COLOR_BG);
+    // 游戏结束画面在撞毁的粒子播完后合成一次，之后保持静止直到按R重启
+    if (game.state == GAME_OVER && game.game_over_drawn) return;
 
-    // 绘制游戏元素（按层次绘制）
-    draw_pipes();
-    draw_coins();
-    draw_ground();
-    draw_bird();
-    draw_score();
+    // 整帧重新合成（多核时按水平条带并行）
+    render_frame();
 
     // 游戏结束时绘制遮罩
-    if (game.state == GAME_OVER) {
+    if (game.state == GAME_OVER && particles.count == 0) {
         draw_game_over();
+        game.game_over_drawn = true;
     }
 
-    // 一次性刷新到屏幕
-    io_write(AM_GPU_FBDRAW, 0, 0, game.frame_buf, game.screen_width, game.screen_height, true);
+    // 只上传本帧发生变化的区域
+    track_damage();
+    present_frame();
 }
 
-// 主游戏循环
+// 主游戏循环：物理按固定步长推进，渲染在两步之间插值，落后时跳过渲染帧追赶
 static void game_loop() {
+    uint64_t last = io_read(AM_TIMER_UPTIME).us;
+    uint64_t last_draw = last;  // 上一次渲染的时间
+    uint64_t lag = 0;     // 尚未模拟的时间
+    int skipped = 0;      // 已连续跳过的渲染帧数
+
     while (1) {
-        handle_input();
-        update_game();
+        uint64_t now = io_read(AM_TIMER_UPTIME).us;
+        lag += now - last;
+        last = now;
+        if (lag > MAX_CATCHUP_TICKS * STEP_US) lag = MAX_CATCHUP_TICKS * STEP_US;
+
+        int steps = 0;
+        while (lag >= STEP_US) {
+            handle_input();
+            update_game();
+            lag -= STEP_US;
+            steps++;
+        }
+
+        if (steps == 0 && now - last_draw < TICK_US) {
+            // 还不到下一个物理步，也不到下一帧（渲染按基础步的频率，物理降频时靠插值补帧），
+            // 等待其中较早的一个
+            uint64_t wait = STEP_US - lag;
+            if (TICK_US - (now - last_draw) < wait) wait = TICK_US - (now - last_draw);
+            delay_us(wait);
+            continue;
+        }
+        if (steps > 1 && skipped < MAX_FRAME_SKIP) {
+            // 渲染跟不上物理，先跳过这一帧
+            skipped++;
+            continue;
+        }
+        skipped = 0;
+
+        game.alpha = lag * SCALE / STEP_US;
         draw_game();
-        delay_us(FRAME_DELAY);
+        last_draw = now;
     }
 }
 
+#ifdef BENCH
+// 粒子微基准：每步补充粒子使池保持满载，分别统计更新和整屏绘制的耗时
+static void particle_bench() {
+    const int ticks = 90;
+    Band full = { 0, game.fb_height };
+    uint64_t update_us = 0, draw_us = 0;
+    for (int t = 0; t < ticks + PARTICLE_TICKS; t++) {
+        particle_burst(game.screen_width / 2, game.screen_height / 2, MAX_PARTICLES / PARTICLE_TICKS + 1,
+                       500, 600, 0, COLOR_BIRD, COLOR_WING);
+        uint64_t t0 = io_read(AM_TIMER_UPTIME).us;
+        update_particles();
+        uint64_t t1 = io_read(AM_TIMER_UPTIME).us;
+        draw_particles(&full);
+        uint64_t t2 = io_read(AM_TIMER_UPTIME).us;
+        if (t >= PARTICLE_TICKS) {  // 前一段只是把池填满
+            update_us += t1 - t0;
+            draw_us += t2 - t1;
+        }
+    }
+    printf("particle benchmark (%d live, per tick): update %d us, draw %d us\n",
+           particles.count, (int)(update_us / ticks), (int)(draw_us / ticks));
+}
+#endif
+
+#ifdef BENCH
+// 渲染微基准：同一帧分别用画家算法和扫描线合成整屏，比较耗时并核对两者逐像素相同
+static void render_bench_one(const char *name) {
+    const int iters = 50;
+    Band full = { 0, game.fb_height };
+    size_t bytes = game.fb_width * game.fb_height * sizeof(uint32_t);
+    uint32_t *ref = (uint32_t*)malloc(bytes);
+
+    // 写入像素数（相对整屏像素数的倍数 * 100）
+    uint64_t px0 = fill_pixels;
+    render_band_painter(&full);
+    uint64_t px1 = fill_pixels;
+    prepare_spans();
+    render_band_spans(&full);
+    uint64_t px2 = fill_pixels;
+    int screen_px = game.fb_width * game.fb_height;
+
+    uint64_t t0 = io_read(AM_TIMER_UPTIME).us;
+    for (int i = 0; i < iters; i++) {
+        render_band_painter(&full);
+    }
+    uint64_t t1 = io_read(AM_TIMER_UPTIME).us;
+    memcpy(ref, game.frame_buf, bytes);
+    memset(game.frame_buf, 0, bytes);
+    for (int i = 0; i < iters; i++) {
+        prepare_spans();
+        render_band_spans(&full);
+    }
+    uint64_t t2 = io_read(AM_TIMER_UPTIME).us;
+
+    printf("%-10s painter %6d us %3d.%02dx  spans %6d us %3d.%02dx  %s\n", name,
+           (int)((t1 - t0) / iters), (int)((px1 - px0) * 100 / screen_px / 100), (int)((px1 - px0) * 100 / screen_px % 100),
+           (int)((t2 - t1) / iters), (int)((px2 - px1) * 100 / screen_px / 100), (int)((px2 - px1) * 100 / screen_px % 100),
+           memcmp(ref, game.frame_buf, bytes) == 0 ? "identical" : "MISMATCH");
+    free(ref);
+}
+
+static void render_bench() {
+    printf("render benchmark (%dx%d buffer, per frame; time and pixels written per screen pixel)\n",
+           game.fb_width, game.fb_height);
+    // 先让小鸟在屏幕中部飞一会儿，攒出几组管道和金币
+    for (int t = 0; t < 400 && game.state == GAME_RUNNING; t++) {
+        if (game.bird_y > game.screen_height * SCALE / 2 && game.velocity > 0) game.velocity = JUMP_FORCE;
+        update_game();
+    }
+    game.coin_score = 3;
+    particles.count = 0;
+    render_bench_one("scene");
+    particle_burst(BIRD_X(game.screen_width), game.screen_height / 2, MAX_PARTICLES, 500, 600, 0,
+                   COLOR_BIRD, COLOR_WING);
+    update_particles();
+    render_bench_one("particles");
+}
+#endif
+
+#ifdef MPE
+static void mpe_entry() {
+    int id = cpu_current();
+    if (id == 0) {
+        game_loop();
+    } else if (id < nr_bands) {
+        render_worker(id);
+    }
+    while (1) ;  // 超出 MAX_HARTS 的核空转
+}
+#endif
+
 int main() {
     ioe_init();
     init_game();
 
+#ifdef BENCH
+    // 只运行填充内核、粒子和渲染的微基准，不进入游戏
+    fill_bench(game.frame_buf, game.fb_width, game.fb_height);
+    particle_bench();
+    render_bench();
+    free_buffers();
+    return 0;
+#endif
+
     printf("Flappy Bird\n");
     printf("按空格键或上方向键跳跃\n");
     printf("避开管道，收集金币加分\n");
     printf("游戏结束后按R键重启\n");
 
+#ifdef MPE
+    // 所有核从 mpe_entry 开始执行，0号核进入游戏循环
+    nr_bands = cpu_count() < MAX_HARTS ? cpu_count() : MAX_HARTS;
+    mpe_init(mpe_entry);
+#endif
     game_loop();
     free_buffers();
     return 0;
@@ -0,0 +1,17 @@
+#ifndef FLAPPY_FILL_H__
+#define FLAPPY_FILL_H__
+
+// 像素填充/拷贝内核（fill.c），dst/src 都是 32 位像素，stride 以像素计
+
+#include <stdint.h>
+
+void fill_row(uint32_t *dst, int n, uint32_t color);
+void fill_rect(uint32_t *dst, int stride, int w, int h, uint32_t color);
+void copy_row(uint32_t *dst, const uint32_t *src, int n);
+
+#ifdef BENCH
+void fill_bench(uint32_t *buf, int width, int height);  // 比较各种矩形填充方式的速度
+extern uint64_t fill_pixels;  // 写入的像素总数，渲染基准用来统计重复绘制
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef FLAPPY_PHYSICS_H__
+#define FLAPPY_PHYSICS_H__
+
+// 游戏模型参数：游戏本体（bird.c）和主机端训练器（tools/trainer.c）共用，
+// 保证训练时的物理、管道生成和碰撞规则与实际游戏一致。
+
+#include <stdint.h>
+
+// 为了避免浮点数运算，使用整数缩放因子
+#define SCALE 100  // 缩放比例，相当于小数点后两位
+
+#define FPS 90             // 物理更新频率（每秒步数），重力、速度等参数都按这个频率调校
+#define TICK_US (1000000 / FPS)  // 物理步长(微秒)
+
+// 游戏元素尺寸（比例定义，使用整数计算）
+#define BIRD_SIZE_RATIO 7    // 小鸟大小占屏幕高度比例 * 100
+#define PIPE_WIDTH_RATIO 12  // 管道宽度占屏幕宽度比例 * 100
+#define PIPE_GAP_RATIO 35    // 管道间隙占屏幕高度比例 * 100
+#define PIPE_SPEED_RATIO 5   // 管道速度占屏幕宽度比例 * 1000
+#define GRAVITY 50           // 重力加速度 * SCALE (原0.5)
+#define JUMP_FORCE -800      // 跳跃力度 * SCALE
+#define GROUND_HEIGHT_RATIO 5 // 地面高度占屏幕高度比例 * 100
+
+// 尺寸下限
+#define MIN_PIPE_SPEED 1
+#define MIN_BIRD_SIZE 8
+#define MIN_PIPE_WIDTH 20
+
+// 小鸟固定在屏幕宽度1/4处
+#define BIRD_X(screen_width) ((screen_width) / 4)
+
+// 管道生成：每隔 max(屏幕宽/速度/2, PIPE_SPAWN_MIN_TICKS) 步生成一个，
+// 间隙中心在 [地面高度 + 间隙/2 + PIPE_GAP_MARGIN, 屏幕高 - 地面高度 - 间隙/2 - PIPE_GAP_MARGIN] 内随机
+#define PIPE_SPAWN_MIN_TICKS 60
+#define PIPE_GAP_MARGIN 20
+
+// 管道口：上下管道在间隙一侧各有一段比管身宽的管口，也参与碰撞
+#define PIPE_LIP_OVERHANG 2  // 管道口两侧比管身宽出的像素
+#define PIPE_LIP_HEIGHT 6    // 管道口高度
+
+// 小鸟模型：精灵和碰撞掩码都由它生成。小鸟按速度倾斜：速度从 BIRD_TILT_V0 到 BIRD_TILT_V1
+// 对应抬头25度到垂直向下，分成 BIRD_ANGLES 个角度
+#define BIRD_ANGLES 16
+#define BIRD_TILT_V0 (JUMP_FORCE * 3 / 4)
+#define BIRD_TILT_V1 (-JUMP_FORCE * 3 / 2)
+#define BIRD_MODEL_R(r) ((r) * 4 / 3 + 1)  // 身体半径为 r 时，连嘴在内任意角度都在 [-R, R) 内
+
+enum { BIRD_PART_NONE, BIRD_PART_PUPIL, BIRD_PART_EYE, BIRD_PART_BEAK, BIRD_PART_WING, BIRD_PART_BODY };
+
+// 旋转角度表：cos、sin * 4096，角度从 -25 度（抬头）到 90 度（垂直向下）均分
+static const int16_t bird_rotation[BIRD_ANGLES][2] = {
+    {3712, -1731}, {3910, -1220}, {4038, -688}, {4094, -143}, {4076, 404}, {3986, 945},
+    {3824, 1468}, {3594, 1965}, {3300, 2427}, {2946, 2845}, {2540, 3213}, {2089, 3523},
+    {1600, 3770}, {1083, 3950}, {546, 4059}, {0, 4096},
+};
+
+// 判断 (u, v) 是否在以 (cu, cv) 为中心、半轴 a、b 的椭圆内（坐标都放大了 256 倍）
+static inline int in_ellipse(int u, int v, int cu, int cv, int a, int b) {
+    int64_t du = u - cu, dv = v - cv;
+    return du * du * b * b + dv * dv * a * a <= (int64_t)a * a * b * b;
+}
+
+// 未旋转的小鸟在 (u, v) 处是哪个部位（头朝右，坐标相对中心、放大 256 倍，r 为身体半径）
+static inline int bird_part(int u, int v, int r) {
+    r *= 256;
+    if (in_ellipse(u, v, r / 2, -r * 3 / 10, r / 8 + 128, r / 8 + 128)) return BIRD_PART_PUPIL;
+    if (in_ellipse(u, v, r * 2 / 5, -r * 3 / 10, r * 3 / 10, r * 3 / 10)) return BIRD_PART_EYE;
+    // 嘴：身体右侧伸出的三角形
+    if (u >= r * 7 / 10 && u <= r * 13 / 10) {
+        int half = (r * 13 / 10 - u) * 2 / 5;
+        if (v - r / 10 <= half && r / 10 - v <= half) return BIRD_PART_BEAK;
+    }
+    if (in_ellipse(u, v, -r / 4, r * 3 / 20, r * 9 / 20, r * 7 / 25)) return BIRD_PART_WING;
+    if (in_ellipse(u, v, 0, 0, r, r * 4 / 5)) return BIRD_PART_BODY;
+    return BIRD_PART_NONE;
+}
+
+// 旋转 angle 后的小鸟在 (dx, dy) 像素处的部位：取像素中心，乘 256 后按 -angle 旋转回
+// 小鸟自身坐标（旋转表是 4096 倍）
+static inline int bird_sample(int r, int angle, int dx, int dy) {
+    int c = bird_rotation[angle][0], s = bird_rotation[angle][1];
+    int x = dx * 256 + 128, y = dy * 256 + 128;
+    return bird_part((x * c + y * s) / 4096, (y * c - x * s) / 4096, r);
+}
+
+// 按速度选最接近的倾斜角度
+static inline int bird_angle_of(int v) {
+    if (v <= BIRD_TILT_V0) return 0;
+    if (v >= BIRD_TILT_V1) return BIRD_ANGLES - 1;
+    return ((v - BIRD_TILT_V0) * (BIRD_ANGLES - 1) + (BIRD_TILT_V1 - BIRD_TILT_V0) / 2) /
+           (BIRD_TILT_V1 - BIRD_TILT_V0);
+}
+
+#endif
@@ -0,0 +1,444 @@
+// 主机端神经进化训练器
+// 用法: trainer [-n 种群大小] [-g 代数] [-j 线程数] [-t 每代最多步数] [-s 种子] [-w 宽] [-h 高]
+// 每一代让整个种群在同一串管道上同时飞行，物理参数、管道生成和小鸟模型取自 ../physics.h，
+// 与游戏里的 update_game 一致。碰撞与游戏的 check_collision 相同：每个倾斜角度的小鸟掩码（含嘴）
+// 对管身、两侧伸出的管口、地面和顶部；只检查每步结束时的位置，不做游戏里的路径扫掠。
+// 小鸟状态和控制网络的权重都按结构数组存放，每步对所有小鸟跑同一个无分支的网络循环，
+// 便于编译器向量化，碰撞查表另跑一遍；种群按线程切块并行模拟。
+// 每代结束后保留最好的一部分个体，其余由它们变异得到。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../physics.h"
+
+#define INPUTS 4      // 小鸟高度、速度、到下一个管道的距离、与间隙中心的高度差
+#define HIDDEN 6
+// 权重布局：输入到隐层 INPUTS*HIDDEN，隐层偏置 HIDDEN，隐层到输出 HIDDEN，输出偏置 1
+#define NR_WEIGHTS (INPUTS * HIDDEN + HIDDEN + HIDDEN + 1)
+#define W_BIAS_H   (INPUTS * HIDDEN)
+#define W_OUT      (W_BIAS_H + HIDDEN)
+#define W_BIAS_OUT (W_OUT + HIDDEN)
+
+#define MAX_PIPES 8
+#define BLOCK 256     // 每个线程按块推进，整块都死掉后提前结束
+#define ELITE_DIV 10  // 保留前 1/ELITE_DIV 的个体
+#define MUTATE_PROB 20  // 每个权重的变异概率（百分比）
+#define MAX_MODEL_R 128   // 小鸟模型半边长上限（屏幕高约 2700 像素以内）
+
+// 由屏幕尺寸算出的游戏尺寸，和 bird.c 的 init_game 相同
+static struct {
+    int width, height;
+    int bird_x, bird_r;
+    int pipe_width, pipe_gap, pipe_speed;
+    int ground_height;
+    int spawn_interval;
+    int min_gap, max_gap;
+} dims;
+
+// 小鸟碰撞掩码的逐列像素段，和游戏里 build_bird_mask 取自同一个模型：第 dx + MAX_MODEL_R 列
+// 自上而下 runs 段不透明像素，第 k 段 dy 为 [top[k], bot[k]]（嘴、翅膀和身体之间会隔开，
+// 最多两段；超过 MASK_RUNS 段的并进最后一段）。x0/x1/y0/y1 为掩码的包围盒（左闭右开），和游戏的 Mask 相同
+#define MASK_RUNS 2
+static struct {
+    int8_t runs[BIRD_ANGLES][2 * MAX_MODEL_R];
+    int16_t top[BIRD_ANGLES][2 * MAX_MODEL_R][MASK_RUNS], bot[BIRD_ANGLES][2 * MAX_MODEL_R][MASK_RUNS];
+    int x0[BIRD_ANGLES], x1[BIRD_ANGLES], y0[BIRD_ANGLES], y1[BIRD_ANGLES];
+} mask;
+
+// 种群（结构数组）：每个权重一列，第 k 个权重的所有个体连续存放
+static int population;
+static float *weights[NR_WEIGHTS], *next_weights[NR_WEIGHTS];
+static int *fitness;  // 存活步数
+static int *passed;   // 穿过的管道数
+
+static int max_ticks = FPS * 120;
+
+typedef struct {
+    int lo, hi;       // 负责的个体范围
+    uint32_t seed;    // 本代管道序列的种子（所有线程相同）
+    uint64_t steps;   // 模拟的小鸟步数（只计存活的）
+} job_t;
+
+static uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+// 快速的 S 形激活函数，避免 tanh 的库调用以便向量化
+static inline float act(float x) {
+    return x / (1.0f + (x < 0 ? -x : x));
+}
+
+static void init_dims(int width, int height) {
+    dims.width = width;
+    dims.height = height;
+    int bird_size = height * BIRD_SIZE_RATIO / 100;
+    dims.pipe_width = width * PIPE_WIDTH_RATIO / 100;
+    dims.pipe_gap = height * PIPE_GAP_RATIO / 100;
+    dims.pipe_speed = width * PIPE_SPEED_RATIO / 1000;
+    dims.ground_height = height * GROUND_HEIGHT_RATIO / 100;
+    if (dims.pipe_speed < MIN_PIPE_SPEED) dims.pipe_speed = MIN_PIPE_SPEED;
+    if (bird_size < MIN_BIRD_SIZE) bird_size = MIN_BIRD_SIZE;
+    if (dims.pipe_width < MIN_PIPE_WIDTH) dims.pipe_width = MIN_PIPE_WIDTH;
+    dims.bird_x = BIRD_X(width);
+    dims.bird_r = bird_size / 2;
+    dims.spawn_interval = (width / dims.pipe_speed) / 2;
+    if (dims.spawn_interval < PIPE_SPAWN_MIN_TICKS) dims.spawn_interval = PIPE_SPAWN_MIN_TICKS;
+    dims.min_gap = dims.ground_height + dims.pipe_gap / 2 + PIPE_GAP_MARGIN;
+    dims.max_gap = height - dims.ground_height - dims.pipe_gap / 2 - PIPE_GAP_MARGIN;
+}
+
+static void init_mask(void) {
+    int r = dims.bird_r, R = BIRD_MODEL_R(r);
+    for (int a = 0; a < BIRD_ANGLES; a++) {
+        mask.x0[a] = mask.y0[a] = R;
+        mask.x1[a] = mask.y1[a] = -R;
+        for (int dx = -R; dx < R; dx++) {
+            int c = dx + MAX_MODEL_R, n = 0, prev = -R - 2;
+            for (int dy = -R; dy < R; dy++) {
+                if (bird_sample(r, a, dx, dy) == BIRD_PART_NONE) continue;
+                if (dy != prev + 1 && n < MASK_RUNS) mask.top[a][c][n++] = dy;
+                mask.bot[a][c][n - 1] = prev = dy;
+            }
+            mask.runs[a][c] = n;
+            if (n == 0) continue;
+            if (dx < mask.x0[a]) mask.x0[a] = dx;
+            mask.x1[a] = dx + 1;
+            if (mask.top[a][c][0] < mask.y0[a]) mask.y0[a] = mask.top[a][c][0];
+            if (mask.bot[a][c][n - 1] + 1 > mask.y1[a]) mask.y1[a] = mask.bot[a][c][n - 1] + 1;
+        }
+    }
+}
+
+// 某个倾斜角度的碰撞规则：中心高度 y 不在 [top, bottom) 内，或落在某条管口带里就撞上
+#define MAX_LIP_BANDS 16
+typedef struct {
+    int top, bottom;
+    int nlip;
+    int lip_lo[MAX_LIP_BANDS], lip_hi[MAX_LIP_BANDS];
+} HitRule;
+
+// 加一条 [lo, hi) 管口带：和上一条重叠就合并，满了就并进最后一条（只会更保守）
+static void add_lip(HitRule *h, int lo, int hi) {
+    if (lo >= hi) return;
+    int k = h->nlip - 1;
+    if (k < 0 || (k < MAX_LIP_BANDS - 1 && (lo > h->lip_hi[k] || hi < h->lip_lo[k]))) {
+        h->lip_lo[++k] = lo;
+        h->lip_hi[k] = hi;
+        h->nlip = k + 1;
+        return;
+    }
+    if (lo < h->lip_lo[k]) h->lip_lo[k] = lo;
+    if (hi > h->lip_hi[k]) h->lip_hi[k] = hi;
+}
+
+// 按当前管道位置建每个角度的碰撞规则，和 check_collision 结果相同。逐列看：
+// 管身列 y + top 高于上管口底边或 y + bot 低于下管口顶边即撞上，只收窄 [top, bottom)；
+// 只有管口伸出的列要和高 PIPE_LIP_HEIGHT 的一条相交，每段像素各记一条管口带
+static void build_hit_rules(HitRule *rule, const int *pipe_x, const int *pipe_gap_y,
+                            int pipe_head, int pipe_count) {
+    int ground_y = dims.height - dims.ground_height;
+    int lip_w = dims.pipe_width + 2 * PIPE_LIP_OVERHANG;
+    for (int a = 0; a < BIRD_ANGLES; a++) {
+        HitRule *h = &rule[a];
+        h->top = -mask.y0[a];                   // 顶部：y + y0 < 0
+        h->bottom = ground_y - mask.y1[a] + 1;  // 地面：y + y1 > ground_y
+        h->nlip = 0;
+        int bx0 = dims.bird_x + mask.x0[a], bx1 = dims.bird_x + mask.x1[a];
+        for (int i = 0; i < pipe_count; i++) {
+            int p = (pipe_head + i) & (MAX_PIPES - 1);
+            int x = pipe_x[p], lip_x = x - PIPE_LIP_OVERHANG;
+            if (lip_x >= bx1) break;
+            int c0 = lip_x > bx0 ? lip_x : bx0, c1 = lip_x + lip_w < bx1 ? lip_x + lip_w : bx1;
+            int gap_top = pipe_gap_y[p] - dims.pipe_gap / 2;
+            int gap_bottom = pipe_gap_y[p] + dims.pipe_gap / 2;
+            for (int cx = c0; cx < c1; cx++) {
+                int c = cx - dims.bird_x + MAX_MODEL_R, n = mask.runs[a][c];
+                if (n == 0) continue;
+                const int16_t *top = mask.top[a][c], *bot = mask.bot[a][c];
+                if (cx >= x && cx < x + dims.pipe_width) {
+                    if (gap_top + PIPE_LIP_HEIGHT - top[0] > h->top) h->top = gap_top + PIPE_LIP_HEIGHT - top[0];
+                    if (gap_bottom - PIPE_LIP_HEIGHT - bot[n - 1] < h->bottom) {
+                        h->bottom = gap_bottom - PIPE_LIP_HEIGHT - bot[n - 1];
+                    }
+                    continue;
+                }
+                for (int k = 0; k < n; k++) {
+                    add_lip(h, gap_top - bot[k], gap_top + PIPE_LIP_HEIGHT - top[k]);
+                    add_lip(h, gap_bottom - PIPE_LIP_HEIGHT - bot[k], gap_bottom - top[k]);
+                }
+            }
+        }
+    }
+}
+
+// 模拟 [lo, lo+n) 这一块小鸟，直到全部撞毁或达到步数上限
+static uint64_t simulate_block(int lo, int n, uint32_t seed) {
+    int y[BLOCK], vy[BLOCK], alive[BLOCK], fit[BLOCK], pipes_passed[BLOCK];
+    int nv[BLOCK], ny[BLOCK];
+    HitRule rule[BIRD_ANGLES];
+    // 管道队列，和游戏一样按生成顺序排列，pipe_ahead 之前的已经被穿过
+    int pipe_x[MAX_PIPES], pipe_gap_y[MAX_PIPES];
+    int pipe_head = 0, pipe_count = 0, pipe_ahead = 0, spawn_timer = 0;
+    float *w[NR_WEIGHTS];
+    for (int k = 0; k < NR_WEIGHTS; k++) w[k] = weights[k] + lo;
+
+    for (int i = 0; i < n; i++) {
+        y[i] = dims.height * SCALE / 2;
+        vy[i] = 0;
+        alive[i] = 1;
+        fit[i] = 0;
+        pipes_passed[i] = 0;
+    }
+
+    const float inv_h = 1.0f / dims.height, inv_w = 1.0f / dims.width;
+    uint64_t steps = 0;
+    int nr_alive = n;
+    for (int t = 0; t < max_ticks && nr_alive > 0; t++) {
+        // 网络输入里和个体无关的部分：下一个管道的位置和间隙
+        int next_dx = dims.width, next_gap = dims.height / 2;
+        if (pipe_ahead < pipe_count) {
+            int p = (pipe_head + pipe_ahead) & (MAX_PIPES - 1);
+            next_dx = pipe_x[p] - dims.bird_x;
+            next_gap = pipe_gap_y[p];
+        }
+        float in_dx = next_dx * inv_w;
+
+        // 管道移动、生成、计分，和 update_pipes_and_coins / update_score 顺序相同
+        for (int i = 0; i < pipe_count; i++) {
+            pipe_x[(pipe_head + i) & (MAX_PIPES - 1)] -= dims.pipe_speed;
+        }
+        while (pipe_count > 0 && pipe_x[pipe_head] + dims.pipe_width < 0) {
+            pipe_head = (pipe_head + 1) & (MAX_PIPES - 1);
+            pipe_count--;
+            if (pipe_ahead > 0) pipe_ahead--;
+        }
+        if (++spawn_timer >= dims.spawn_interval) {
+            spawn_timer = 0;
+            if (pipe_count < MAX_PIPES) {
+                int p = (pipe_head + pipe_count++) & (MAX_PIPES - 1);
+                pipe_x[p] = dims.width;
+                pipe_gap_y[p] = dims.min_gap + xorshift32(&seed) % (dims.max_gap - dims.min_gap + 1);
+            }
+        }
+        int score = 0;
+        while (pipe_ahead < pipe_count &&
+               pipe_x[(pipe_head + pipe_ahead) & (MAX_PIPES - 1)] + dims.pipe_width < dims.bird_x - dims.bird_r) {
+            pipe_ahead++;
+            score = 1;
+        }
+
+        // 碰撞规则对所有小鸟相同，每步按管道位置给每个角度建一份，
+        // 每只鸟只和自己角度的上下界（和管口带）比较
+        build_hit_rules(rule, pipe_x, pipe_gap_y, pipe_head, pipe_count);
+
+        // 每只小鸟：网络决定是否跳跃，然后按游戏的顺序算出新的速度和位置
+        for (int i = 0; i < n; i++) {
+            float in[INPUTS] = {
+                y[i] * (inv_h / SCALE),
+                vy[i] * (1.0f / (-JUMP_FORCE)),
+                in_dx,
+                (next_gap * SCALE - y[i]) * (inv_h / SCALE),
+            };
+            float out = w[W_BIAS_OUT][i];
+            for (int h = 0; h < HIDDEN; h++) {
+                float sum = w[W_BIAS_H + h][i];
+                for (int k = 0; k < INPUTS; k++) {
+                    sum += in[k] * w[h * INPUTS + k][i];
+                }
+                out += act(sum) * w[W_OUT + h][i];
+            }
+            nv[i] = (out > 0 ? JUMP_FORCE : vy[i]) + GRAVITY;
+            ny[i] = y[i] + nv[i];
+        }
+
+        // 碰撞要按角度查表，单独一遍，不拖慢上面能向量化的网络计算
+        int alive_now = 0;
+        for (int i = 0; i < n; i++) {
+            int a = alive[i];
+            int py = ny[i] / SCALE;
+            const HitRule *h = &rule[bird_angle_of(nv[i])];
+            int crash = (py < h->top) | (py >= h->bottom);
+            for (int k = 0; k < h->nlip; k++) crash |= (py >= h->lip_lo[k]) & (py < h->lip_hi[k]);
+            // 撞毁的小鸟保持原状态
+            vy[i] = a ? nv[i] : vy[i];
+            y[i] = a ? ny[i] : y[i];
+            pipes_passed[i] += a & score & !crash;  // 游戏里撞上的那一步不计分
+            a &= !crash;
+            alive[i] = a;
+            fit[i] += a;
+            alive_now += a;
+        }
+        steps += nr_alive;
+        nr_alive = alive_now;
+    }
+
+    for (int i = 0; i < n; i++) {
+        fitness[lo + i] = fit[i];
+        passed[lo + i] = pipes_passed[i];
+    }
+    return steps;
+}
+
+static void *worker(void *arg) {
+    job_t *job = arg;
+    job->steps = 0;
+    for (int lo = job->lo; lo < job->hi; lo += BLOCK) {
+        int n = job->hi - lo < BLOCK ? job->hi - lo : BLOCK;
+        job->steps += simulate_block(lo, n, job->seed);
+    }
+    return NULL;
+}
+
+// 均值为0的近似正态分布随机数（四个均匀分布之和）
+static float rand_normal(uint32_t *s) {
+    float sum = 0;
+    for (int i = 0; i < 4; i++) sum += (xorshift32(s) & 0xffff) * (1.0f / 65536);
+    return (sum - 2.0f) * 1.7f;
+}
+
+static int *rank_tmp;
+static int cmp_fitness(const void *a, const void *b) {
+    int fa = fitness[*(const int *)a], fb = fitness[*(const int *)b];
+    return fb - fa;
+}
+
+// 按适应度排序，精英原样保留到前面，其余个体从精英中随机挑选父代变异得到
+static void evolve(uint32_t *rng) {
+    for (int i = 0; i < population; i++) rank_tmp[i] = i;
+    qsort(rank_tmp, population, sizeof(int), cmp_fitness);
+
+    int elite = population / ELITE_DIV > 0 ? population / ELITE_DIV : 1;
+    for (int i = 0; i < population; i++) {
+        int parent = rank_tmp[i < elite ? i : xorshift32(rng) % elite];
+        for (int k = 0; k < NR_WEIGHTS; k++) {
+            float v = weights[k][parent];
+            if (i >= elite && xorshift32(rng) % 100 < MUTATE_PROB) {
+                v += rand_normal(rng) * 0.3f;
+            }
+            next_weights[k][i] = v;
+        }
+    }
+    for (int k = 0; k < NR_WEIGHTS; k++) {
+        float *t = weights[k];
+        weights[k] = next_weights[k];
+        next_weights[k] = t;
+    }
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+    int generations = 50, threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int width = 400, height = 300;
+    uint32_t seed = 1;
+    population = 4096;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:g:j:t:s:w:h:")) != -1) {
+        switch (opt) {
+            case 'n': population = atoi(optarg); break;
+            case 'g': generations = atoi(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 't': max_ticks = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'w': width = atoi(optarg); break;
+            case 'h': height = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n population] [-g generations] [-j threads] "
+                                "[-t max ticks] [-s seed] [-w width] [-h height]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (population < 1 || threads < 1 || seed == 0) {
+        fprintf(stderr, "population and threads must be positive, seed non-zero\n");
+        return 1;
+    }
+    init_dims(width, height);
+    if (BIRD_MODEL_R(dims.bird_r) > MAX_MODEL_R) {
+        fprintf(stderr, "screen too large\n");
+        return 1;
+    }
+    init_mask();
+
+    for (int k = 0; k < NR_WEIGHTS; k++) {
+        weights[k] = malloc(population * sizeof(float));
+        next_weights[k] = malloc(population * sizeof(float));
+        if (!weights[k] || !next_weights[k]) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    fitness = malloc(population * sizeof(int));
+    passed = malloc(population * sizeof(int));
+    rank_tmp = malloc(population * sizeof(int));
+    if (!fitness || !passed || !rank_tmp) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    uint32_t rng = seed;
+    for (int k = 0; k < NR_WEIGHTS; k++) {
+        for (int i = 0; i < population; i++) weights[k][i] = rand_normal(&rng);
+    }
+
+    pthread_t *tid = malloc(threads * sizeof(pthread_t));
+    job_t *jobs = malloc(threads * sizeof(job_t));
+    printf("%d birds, %d threads, %dx%d screen, up to %d ticks per generation\n",
+           population, threads, width, height, max_ticks);
+
+    uint64_t total_steps = 0;
+    double total_time = 0;
+    for (int g = 0; g < generations; g++) {
+        // 同一代所有个体面对相同的管道序列
+        uint32_t pipe_seed = xorshift32(&rng) | 1;
+        double start = now_sec();
+        // 按 BLOCK 对齐切块
+        int per = ((population + threads - 1) / threads + BLOCK - 1) / BLOCK * BLOCK;
+        for (int t = 0; t < threads; t++) {
+            jobs[t].lo = t * per < population ? t * per : population;
+            jobs[t].hi = jobs[t].lo + per < population ? jobs[t].lo + per : population;
+            jobs[t].seed = pipe_seed;
+            pthread_create(&tid[t], NULL, worker, &jobs[t]);
+        }
+        uint64_t steps = 0;
+        for (int t = 0; t < threads; t++) {
+            pthread_join(tid[t], NULL);
+            steps += jobs[t].steps;
+        }
+        double elapsed = now_sec() - start;
+        total_steps += steps;
+        total_time += elapsed;
+
+        int best = 0;
+        long long sum = 0;
+        for (int i = 0; i < population; i++) {
+            if (fitness[i] > fitness[best]) best = i;
+            sum += fitness[i];
+        }
+        printf("gen %3d  best %6d ticks %4d pipes  mean %8.1f  %6.1f M bird-steps/s\n",
+               g, fitness[best], passed[best], (double)sum / population,
+               elapsed > 0 ? steps / elapsed / 1e6 : 0.0);
+        fflush(stdout);
+
+        evolve(&rng);
+    }
+
+    if (total_time > 0) {
+        printf("%llu bird-steps in %.2f s: %.1f M bird-steps/s (%.0f birds in real time at %d Hz)\n",
+               (unsigned long long)total_steps, total_time, total_steps / total_time / 1e6,
+               total_steps / total_time / FPS, FPS);
+    }
+    return 0;
+}
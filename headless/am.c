@@ -0,0 +1,365 @@
+// 无头 AM 运行时：在普通 Linux 上运行游戏，不需要显示器
+//
+// 时钟是虚拟的：每次读计时器或键盘前进 READ_US 微秒，每次同步帧前进 SYNC_US 微秒，
+// 输入按脚本在指定的虚拟时刻送出，所以同一脚本每次运行得到完全相同的画面序列。
+// 每次同步时对合成后的整屏算 CRC32，连续相同的帧只记一次（去掉多余的同步不影响结果）。
+//
+// 环境变量：
+//   AM_SCRIPT  输入脚本（见 scripts/ 下的例子）
+//   AM_HASHES  把各帧的哈希写到这个文件
+//   AM_GOLDEN  与这个文件里的哈希逐帧比较，不一致时以非零状态退出
+//   AM_DUMP    目录：有 AM_GOLDEN 时只导出不一致的帧，否则导出所有帧（PPM 格式）
+//   AM_CPUS    模拟的处理器核数（mpe_init 用线程实现），默认为 1
+#include <am.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define READ_US 10        // 每次读设备寄存器前进的时间
+#define SYNC_US 10000     // 每次同步帧前进的时间
+#define MAX_EVENTS 8192
+#define PRESS_US 20000    // press 命令按下到松开的时间
+#define MAX_DUMPS 16      // 比较时最多导出的不一致帧数
+
+static char heap_mem[64 << 20];
+Area heap = { heap_mem, heap_mem + sizeof(heap_mem) };
+
+static int screen_w = 400, screen_h = 300;
+static uint32_t *fb;
+static bool fb_changed = true;
+static uint64_t now_us;
+static uint64_t end_us = 20000000;
+
+typedef struct {
+  uint64_t t;
+  int key;
+  bool down;
+} Event;
+
+static Event events[MAX_EVENTS];
+static int nevents, next_event;
+
+static FILE *hash_out;
+static uint32_t *golden;
+static int ngolden;
+static const char *dump_dir;
+static int frames, distinct, mismatches, dumps;
+static uint32_t last_crc;
+
+// 游戏一般只在0号核上访问设备，加锁以防其它核也来读写
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t crc_table[256];
+
+static void init_crc(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) {
+      c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    }
+    crc_table[i] = c;
+  }
+}
+
+static uint32_t crc32(const void *data, size_t n) {
+  const uint8_t *p = data;
+  uint32_t c = 0xffffffffu;
+  for (size_t i = 0; i < n; i++) {
+    c = crc_table[(c ^ p[i]) & 0xff] ^ (c >> 8);
+  }
+  return c ^ 0xffffffffu;
+}
+
+static const char *key_names[] = {
+  "NONE",
+#define KEY_NAME(k) #k,
+  AM_KEYS(KEY_NAME)
+};
+
+static int key_by_name(const char *name) {
+  for (int i = 0; i < (int)(sizeof(key_names) / sizeof(key_names[0])); i++) {
+    if (strcmp(key_names[i], name) == 0) return i;
+  }
+  return -1;
+}
+
+static void add_event(uint64_t t, int key, bool down) {
+  if (nevents == MAX_EVENTS) {
+    fprintf(stderr, "am: too many input events\n");
+    exit(2);
+  }
+  events[nevents++] = (Event){ t, key, down };
+}
+
+// 脚本每行一条命令，# 开头为注释：
+//   seed <us>            虚拟时钟的初始值（游戏多用它做随机数种子）
+//   screen <w> <h>       屏幕尺寸
+//   end <us>             运行多久后结束（从初始值算起）
+//   at <us> press <KEY>  按下并在 PRESS_US 后松开
+//   at <us> down <KEY>   按下
+//   at <us> up <KEY>     松开
+static void load_script(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+  char line[256], op[32], key[32];
+  unsigned long long t;
+  for (int lineno = 1; fgets(line, sizeof(line), f); lineno++) {
+    if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') continue;
+    if (sscanf(line, "seed %llu", &t) == 1) {
+      now_us = t;
+    } else if (sscanf(line, "end %llu", &t) == 1) {
+      end_us = t;
+    } else if (sscanf(line, "screen %d %d", &screen_w, &screen_h) == 2) {
+      continue;
+    } else if (sscanf(line, "at %llu %31s %31s", &t, op, key) == 3 && key_by_name(key) >= 0) {
+      int k = key_by_name(key);
+      if (strcmp(op, "press") == 0) {
+        add_event(t, k, true);
+        add_event(t + PRESS_US, k, false);
+      } else if (strcmp(op, "down") == 0 || strcmp(op, "up") == 0) {
+        add_event(t, k, op[0] == 'd');
+      } else {
+        goto bad;
+      }
+    } else {
+      goto bad;
+    }
+    continue;
+bad:
+    fprintf(stderr, "%s:%d: bad line: %s", path, lineno, line);
+    exit(2);
+  }
+  fclose(f);
+  // press 产生的松开事件可能排在后面命令之后，按时间稳定排序
+  for (int i = 1; i < nevents; i++) {
+    Event e = events[i];
+    int j = i;
+    for (; j > 0 && events[j - 1].t > e.t; j--) {
+      events[j] = events[j - 1];
+    }
+    events[j] = e;
+  }
+}
+
+static void load_golden(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+  char line[64];
+  int cap = 0;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned int h;
+    if (line[0] == '#' || sscanf(line, "%x", &h) != 1) continue;
+    if (ngolden == cap) {
+      cap = cap ? cap * 2 : 1024;
+      golden = realloc(golden, cap * sizeof(uint32_t));
+    }
+    golden[ngolden++] = h;
+  }
+  fclose(f);
+}
+
+static void dump_frame(int index) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%05d.ppm", dump_dir, index);
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", screen_w, screen_h);
+  for (int i = 0; i < screen_w * screen_h; i++) {
+    uint32_t p = fb[i];
+    fputc((p >> 16) & 0xff, f);
+    fputc((p >> 8) & 0xff, f);
+    fputc(p & 0xff, f);
+  }
+  fclose(f);
+}
+
+// 记录一帧（与上一帧相同的不记）
+static void present(void) {
+  frames++;
+  if (!fb_changed) return;
+  fb_changed = false;
+  uint32_t crc = crc32(fb, (size_t)screen_w * screen_h * sizeof(uint32_t));
+  if (distinct > 0 && crc == last_crc) return;
+  last_crc = crc;
+  if (hash_out) fprintf(hash_out, "%08x\n", crc);
+  if (golden) {
+    if (distinct >= ngolden || golden[distinct] != crc) {
+      if (mismatches++ == 0) {
+        if (distinct < ngolden) {
+          fprintf(stderr, "am: frame %d: expected %08x, got %08x\n", distinct, golden[distinct], crc);
+        } else {
+          fprintf(stderr, "am: frame %d: extra frame %08x\n", distinct, crc);
+        }
+      }
+      if (dump_dir && dumps < MAX_DUMPS) {
+        dump_frame(distinct);
+        dumps++;
+      }
+    }
+  } else if (dump_dir) {
+    dump_frame(distinct);
+  }
+  distinct++;
+}
+
+// 退出时汇总，比较失败则改为以1退出
+static void finish(void) {
+  if (hash_out) fclose(hash_out);
+  int status = 0;
+  if (golden) {
+    if (mismatches == 0 && distinct < ngolden) {
+      fprintf(stderr, "am: %d frames, expected %d\n", distinct, ngolden);
+      mismatches++;
+    }
+    status = mismatches > 0;
+  }
+  fprintf(stderr, "am: %s%d frames (%d distinct), %d mismatches, t=%llu us\n", status ? "FAIL: " : "",
+          frames, distinct, mismatches, (unsigned long long)now_us);
+  if (status) {
+    fflush(NULL);
+    _exit(1);
+  }
+}
+
+static void advance(uint64_t us) {
+  now_us += us;
+  if (now_us >= end_us) exit(0);
+}
+
+void putch(char ch) {
+  putchar(ch);
+}
+
+void halt(int code) {
+  exit(code);
+}
+
+bool ioe_init(void) {
+  init_crc();
+  const char *s = getenv("AM_SCRIPT");
+  if (s) load_script(s);
+  end_us += now_us;
+  for (int i = 0; i < nevents; i++) {
+    events[i].t += now_us;
+  }
+  fb = calloc((size_t)screen_w * screen_h, sizeof(uint32_t));
+  if ((s = getenv("AM_HASHES"))) {
+    hash_out = fopen(s, "w");
+    if (!hash_out) {
+      perror(s);
+      exit(2);
+    }
+  }
+  if ((s = getenv("AM_GOLDEN"))) load_golden(s);
+  dump_dir = getenv("AM_DUMP");
+  atexit(finish);
+  return true;
+}
+
+void ioe_read(int reg, void *buf) {
+  pthread_mutex_lock(&io_lock);
+  switch (reg) {
+    case AM_TIMER_CONFIG: *(AM_TIMER_CONFIG_T *)buf = (AM_TIMER_CONFIG_T){ .present = true }; break;
+    case AM_INPUT_CONFIG: *(AM_INPUT_CONFIG_T *)buf = (AM_INPUT_CONFIG_T){ .present = true }; break;
+    case AM_GPU_CONFIG:
+      *(AM_GPU_CONFIG_T *)buf = (AM_GPU_CONFIG_T){
+        .present = true, .width = screen_w, .height = screen_h, .vmemsz = screen_w * screen_h * 4
+      };
+      break;
+    case AM_TIMER_UPTIME:
+      advance(READ_US);
+      ((AM_TIMER_UPTIME_T *)buf)->us = now_us;
+      break;
+    case AM_INPUT_KEYBRD: {
+      AM_INPUT_KEYBRD_T *kbd = buf;
+      advance(READ_US);
+      if (next_event < nevents && events[next_event].t <= now_us) {
+        kbd->keydown = events[next_event].down;
+        kbd->keycode = events[next_event].key;
+        next_event++;
+      } else {
+        kbd->keydown = false;
+        kbd->keycode = AM_KEY_NONE;
+      }
+      break;
+    }
+    default:
+      fprintf(stderr, "am: unsupported read of register %d\n", reg);
+      exit(2);
+  }
+  pthread_mutex_unlock(&io_lock);
+}
+
+void ioe_write(int reg, void *buf) {
+  if (reg != AM_GPU_FBDRAW) {
+    fprintf(stderr, "am: unsupported write of register %d\n", reg);
+    exit(2);
+  }
+  pthread_mutex_lock(&io_lock);
+  AM_GPU_FBDRAW_T *d = buf;
+  const uint32_t *pixels = d->pixels;
+  if (pixels) {
+    for (int j = 0; j < d->h; j++) {
+      int y = d->y + j;
+      if (y < 0 || y >= screen_h) continue;
+      for (int i = 0; i < d->w; i++) {
+        int x = d->x + i;
+        if (x < 0 || x >= screen_w) continue;
+        uint32_t v = pixels[j * d->w + i];
+        if (fb[y * screen_w + x] != v) {
+          fb[y * screen_w + x] = v;
+          fb_changed = true;
+        }
+      }
+    }
+  }
+  if (d->sync) {
+    present();
+    advance(SYNC_US);
+  }
+  pthread_mutex_unlock(&io_lock);
+}
+
+// 多核扩展：每个核一个线程
+static __thread int this_cpu;
+static void (*mpe_entry)();
+
+static void *cpu_thread(void *arg) {
+  this_cpu = (int)(intptr_t)arg;
+  mpe_entry();
+  return NULL;
+}
+
+int cpu_count(void) {
+  const char *s = getenv("AM_CPUS");
+  return s && atoi(s) > 0 ? atoi(s) : 1;
+}
+
+int cpu_current(void) {
+  return this_cpu;
+}
+
+bool mpe_init(void (*entry)()) {
+  mpe_entry = entry;
+  for (int i = 1; i < cpu_count(); i++) {
+    pthread_t t;
+    pthread_create(&t, NULL, cpu_thread, (void *)(intptr_t)i);
+  }
+  entry();
+  exit(0);
+}
+
+int atomic_xchg(int *addr, int newval) {
+  return __atomic_exchange_n(addr, newval, __ATOMIC_SEQ_CST);
+}
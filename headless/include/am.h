@@ -0,0 +1,19 @@
+// 无头运行时（../am.c）用的 AM 头文件，只包含游戏用到的部分
+#ifndef AM_H__
+#define AM_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+typedef struct { void *start, *end; } Area;
+extern Area heap;
+void putch(char ch);
+void halt(int code) __attribute__((__noreturn__));
+bool ioe_init(void);
+void ioe_read(int reg, void *buf);
+void ioe_write(int reg, void *buf);
+#include "amdev.h"
+bool mpe_init(void (*entry)());
+int cpu_count(void);
+int cpu_current(void);
+int atomic_xchg(int *addr, int newval);
+#endif
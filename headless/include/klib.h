@@ -0,0 +1,11 @@
+// 无头运行时用的 klib：直接使用主机的 C 库
+#ifndef KLIB_H__
+#define KLIB_H__
+#include <am.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#endif
@@ -4,13 +4,27 @@
 #include <am.h>
 #include <amdev.h>
 #include <klib-macros.h>
+#include "sokoban.h"
+#include "levelpack.h"
+
+#ifdef __ISA_NATIVE__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 // 游戏常量定义
-#define GRID_SIZE 10          // 游戏地图尺寸(10x10)
+#define GRID_MAX LEVELPACK_MAX_DIM // 地图数组的尺寸，关卡实际大小为 level_w x level_h
 #define TILE_SIZE 32          // 每个格子的像素大小
 #define FPS 10                // 帧率控制
 #define FRAME_DELAY (1000000 / FPS)  // 每帧延迟(微秒)
 #define INT_MAX   100000
+#define HINT_MAX_NODES 200000 // 提示时求解器最多保存的节点数
+#define HINT_MAX_MOVES 1024   // 提示缓存的最长解
+#define FREEZE_MAX 64         // 一次冻结检查最多牵涉的箱子数
+#define CORRAL_MAX 32         // 只检查不超过这么多格的封闭区域
+#define CLEAR_ROWS 16         // 清屏时每次 FBDRAW 的行数
 
 // 颜色定义
 #define COLOR_WALL        0x008B4513  // 墙壁棕色
@@ -19,22 +33,10 @@
 #define COLOR_TARGET      0x0000CED1  // 目标点青色
 #define COLOR_PLAYER      0x00FF6347  // 玩家红色
 #define COLOR_BOX_ON_TARGET 0x00FF4500  // 目标点上的箱子（橙色）
+#define COLOR_BOX_DEAD    0x00808080  // 死锁的箱子（灰色）
 #define COLOR_WHITE       0x00FFFFFF  // 白色（文字）
 #define COLOR_GREEN       0x0000FF00  // 绿色（胜利文字）
 
-// 游戏元素枚举 - 分离基础元素和叠加元素
-typedef enum {
-    BASE_FLOOR,    // 基础地板
-    BASE_WALL,     // 基础墙壁
-    BASE_TARGET    // 基础目标点
-} BaseType;
-
-typedef enum {
-    OVERLAY_NONE,  // 无叠加元素
-    OVERLAY_BOX,   // 箱子
-    OVERLAY_PLAYER // 玩家
-} OverlayType;
-
 // 游戏状态枚举
 typedef enum {
     PLAYING,
@@ -45,32 +47,15 @@ typedef enum {
 // 玩家位置
 static int player_x, player_y;
 
-// 游戏地图 - 分离基础元素和叠加元素
-static BaseType base_map[GRID_SIZE][GRID_SIZE] = {
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL , BASE_WALL , BASE_WALL  , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL , BASE_WALL , BASE_WALL  , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_FLOOR , BASE_FLOOR , BASE_WALL , BASE_FLOOR, BASE_FLOOR , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_FLOOR , BASE_FLOOR , BASE_FLOOR , BASE_WALL , BASE_FLOOR, BASE_FLOOR , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_FLOOR , BASE_FLOOR , BASE_FLOOR , BASE_FLOOR, BASE_FLOOR, BASE_FLOOR , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_FLOOR , BASE_FLOOR , BASE_WALL  , BASE_WALL , BASE_FLOOR, BASE_FLOOR , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_FLOOR , BASE_FLOOR , BASE_FLOOR , BASE_WALL , BASE_FLOOR, BASE_WALL  , BASE_WALL},
-    {BASE_WALL, BASE_TARGET, BASE_TARGET, BASE_TARGET, BASE_TARGET, BASE_TARGET, BASE_FLOOR, BASE_FLOOR, BASE_WALL  , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL , BASE_WALL , BASE_WALL  , BASE_WALL},
-    {BASE_WALL, BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL  , BASE_WALL , BASE_WALL , BASE_WALL  , BASE_WALL}
-};
-
-static OverlayType overlay_map[GRID_SIZE][GRID_SIZE] = {
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_PLAYER, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_BOX , OVERLAY_NONE, OVERLAY_BOX , OVERLAY_NONE, OVERLAY_BOX , OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_BOX , OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_BOX , OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE},
-    {OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE, OVERLAY_NONE}
-};
+// 游戏地图 - 分离基础元素和叠加元素。关卡从关卡包载入，放在左上角，关卡以外的格子都是墙
+static BaseType base_map[GRID_MAX][GRID_MAX];
+static OverlayType overlay_map[GRID_MAX][GRID_MAX];
+static int level_w, level_h;
+
+// 关卡包：默认用编进游戏的 levelpack_builtin，native 下可以用 PUSH_BOX_LEVELS 指定外部文件
+static const uint8_t *level_pack;
+static size_t level_pack_size;
+static int level_count, level_index;
 
 // 游戏状态和统计信息
 static GameState game_state = PLAYING;
@@ -78,16 +63,49 @@ static int moves = 0;          // 移动步数
 static int boxes_on_target = 0; // 目标点上的箱子数量
 static int total_targets = 0;   // 总目标点数量
 
+// 提示：求出当前局面推动次数最少的解，按一次 H 走一步。
+// 解缓存起来，连续按 H 时不重新求解；玩家自己走了一步后缓存作废。
+static char hint_moves[HINT_MAX_MOVES];
+static int hint_pos = -1; // 下一步在 hint_moves 中的位置，-1 表示没有缓存的解
+
+// 移动日志：每步一个字节，低2位是方向（DIR_LEFT 等，LURD 顺序），LOG_PUSH 位表示推了箱子。
+// 撤销时把最后一步反着走一遍，不保存整张地图；撤销过的步留在 log_len 之后，直到走了新的一步
+static uint8_t *move_log = NULL;
+static int log_len, log_end, log_cap; // 已走的步数、可以重做到的位置、缓冲区大小
+#define LOG_PUSH 4
+
+// 死锁记录：每次推动新标记的死锁箱子（格子下标 y * GRID_MAX + x）依次入栈，推动结束时压一个
+// DEAD_END；被推的箱子原来就是死锁的，先记一项 DEAD_RESTORE | 原格子。撤销推动时弹出这一段，
+// 标记恢复成推动前的样子。撤销总是先撤后来的推动，所以不用重新做死锁检查
+static uint16_t *dead_log = NULL;
+static int dead_len, dead_cap;
+#define DEAD_END     0xffff
+#define DEAD_RESTORE 0x8000
+
+static const int dir_dx[4] = { -1, 0, 1, 0 }, dir_dy[4] = { 0, -1, 0, 1 };
+
 // 屏幕信息
 static int screen_width, screen_height;
 static int grid_offset_x, grid_offset_y;
 
 // 预分配的缓冲区，避免频繁malloc/free
 static uint32_t *tile_buf = NULL;
-static uint32_t *player_buf = NULL;
-static uint32_t *box_buf = NULL;
+static uint32_t *clear_buf = NULL;
 static uint32_t *char_buf = NULL;
 
+// 增量重绘：关卡开始时整屏画一次，之后只重画改动过的格子和步数；什么都没变的帧不发任何 FBDRAW
+static bool redraw_all = true;                 // 下一帧整屏重画
+static bool info_dirty = true;                 // 下一帧重画步数和胜利提示
+static uint8_t dirty[GRID_MAX][GRID_MAX];      // 下一帧要重画的格子
+static int nr_dirty;
+
+static void mark_dirty(int x, int y) {
+    if (!dirty[y][x]) {
+        dirty[y][x] = 1;
+        nr_dirty++;
+    }
+}
+
 // 安全绘制检查：确保绘制区域在屏幕范围内
 static bool is_drawable(int x, int y, int w, int h) {
     return (x >= 0) && (y >= 0) && 
@@ -99,34 +117,218 @@ static bool is_drawable(int x, int y, int w, int h) {
 static void init_buffers() {
     // 只分配一次，避免频繁malloc/free导致的内存碎片
     tile_buf = (uint32_t*)malloc(TILE_SIZE * TILE_SIZE * sizeof(uint32_t));
-    int player_size = TILE_SIZE / 2;
-    player_buf = (uint32_t*)malloc(player_size * player_size * sizeof(uint32_t));
-    int box_size = TILE_SIZE * 3 / 4;
-    box_buf = (uint32_t*)malloc(box_size * box_size * sizeof(uint32_t));
+    clear_buf = (uint32_t*)malloc(screen_width * CLEAR_ROWS * sizeof(uint32_t));
+    if (clear_buf) memset(clear_buf, 0, screen_width * CLEAR_ROWS * sizeof(uint32_t));
     char_buf = (uint32_t*)malloc(10 * 10 * sizeof(uint32_t)); // 字符缓冲区
 }
 
 // 释放缓冲区
 static void free_buffers() {
     if (tile_buf) free(tile_buf);
-    if (player_buf) free(player_buf);
-    if (box_buf) free(box_buf);
+    if (clear_buf) free(clear_buf);
+    if (move_log) free(move_log);
+    if (dead_log) free(dead_log);
     if (char_buf) free(char_buf);
 }
 
-// 初始化游戏
-static void init_game() {
-    // 获取屏幕尺寸
-    AM_GPU_CONFIG_T gpu_cfg = io_read(AM_GPU_CONFIG);
-    screen_width = gpu_cfg.width;
-    screen_height = gpu_cfg.height;
-    
-    // 初始化缓冲区
-    init_buffers();
+// 死锁检测：关卡载入时算好静态死格，之后每次推动只检查被推箱子附近的局部，
+// 不做整图扫描。判定为死锁的箱子画成灰色。
+static uint8_t dead_square[GRID_MAX][GRID_MAX]; // 箱子推上去就再也到不了目标点的格子
+static uint8_t box_dead[GRID_MAX][GRID_MAX];    // 已判定死锁的箱子
+static uint8_t as_wall[GRID_MAX][GRID_MAX];     // 冻结检查中暂时当作墙的箱子（递归返回前清除）
+static uint8_t corral_mark[GRID_MAX][GRID_MAX]; // 封闭区域检查中已访问的格子（检查完清除）
+
+// 冻结检查中确认冻结的箱子
+static int frozen_x[FREEZE_MAX], frozen_y[FREEZE_MAX];
+static int nr_frozen;
+
+static void log_dead(uint16_t entry);
+
+static void mark_box_dead(int x, int y) {
+    if (!box_dead[y][x]) log_dead(y * GRID_MAX + x);
+    box_dead[y][x] = 1;
+    mark_dirty(x, y);
+}
+
+static bool blocks_box(int x, int y) {
+    return x < 0 || x >= level_w || y < 0 || y >= level_h || base_map[y][x] == BASE_WALL || as_wall[y][x];
+}
+
+static bool is_frozen(int x, int y);
+
+// 箱子 (x,y) 沿 (dx,dy) 这条轴是否推不动：一侧是墙、两侧都是死格，或者一侧是冻结的箱子
+static bool axis_blocked(int x, int y, int dx, int dy) {
+    int ax = x - dx, ay = y - dy, bx = x + dx, by = y + dy;
+    if (blocks_box(ax, ay) || blocks_box(bx, by)) return true;
+    if (dead_square[ay][ax] && dead_square[by][bx]) return true;
+    if (overlay_map[ay][ax] == OVERLAY_BOX && is_frozen(ax, ay)) return true;
+    if (overlay_map[by][bx] == OVERLAY_BOX && is_frozen(bx, by)) return true;
+    return false;
+}
+
+// 箱子是否冻结（横竖都推不动）。检查相邻箱子时把自己当作墙，递归只沿相互挨着的箱子展开。
+// 冻结的箱子追加到 frozen_x/y；判定为没冻结时撤销递归中追加的记录。
+static bool is_frozen(int x, int y) {
+    if (nr_frozen == FREEZE_MAX) return false; // 牵涉太多箱子时保守地当作没冻结
+    int saved = nr_frozen;
+    as_wall[y][x] = 1;
+    bool frozen = axis_blocked(x, y, 1, 0) && axis_blocked(x, y, 0, 1);
+    as_wall[y][x] = 0;
+    if (!frozen) {
+        nr_frozen = saved;
+        return false;
+    }
+    frozen_x[nr_frozen] = x;
+    frozen_y[nr_frozen] = y;
+    nr_frozen++;
+    return true;
+}
+
+// 从空格 (sx,sy) 出发找封闭区域（墙和箱子围住、玩家不在里面、不超过 CORRAL_MAX 格）。
+// 如果里面有空的目标点，而围住它的箱子全都冻结，这个目标点就再也放不上箱子了。
+// 是死锁时把围住它的箱子标记为死锁并返回 true。
+static bool sealed_corral(int sx, int sy) {
+    static int cx[CORRAL_MAX], cy[CORRAL_MAX];
+    static const int dirs[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+    int n = 0;
+    bool closed = true, has_target = false;
+    cx[n] = sx;
+    cy[n++] = sy;
+    corral_mark[sy][sx] = 1;
+    for (int i = 0; i < n && closed; i++) {
+        if (overlay_map[cy[i]][cx[i]] == OVERLAY_PLAYER) closed = false;
+        has_target |= base_map[cy[i]][cx[i]] == BASE_TARGET;
+        for (int d = 0; d < 4 && closed; d++) {
+            int x = cx[i] + dirs[d][0], y = cy[i] + dirs[d][1];
+            if (blocks_box(x, y) || overlay_map[y][x] == OVERLAY_BOX || corral_mark[y][x]) continue;
+            if (n == CORRAL_MAX) {
+                closed = false;
+                break;
+            }
+            corral_mark[y][x] = 1;
+            cx[n] = x;
+            cy[n++] = y;
+        }
+    }
+    bool sealed = closed && has_target;
+    // 围住区域的箱子是否全都冻结
+    for (int i = 0; i < n && sealed; i++) {
+        for (int d = 0; d < 4 && sealed; d++) {
+            int x = cx[i] + dirs[d][0], y = cy[i] + dirs[d][1];
+            if (blocks_box(x, y) || overlay_map[y][x] != OVERLAY_BOX) continue;
+            nr_frozen = 0;
+            sealed = is_frozen(x, y);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        corral_mark[cy[i]][cx[i]] = 0;
+        for (int d = 0; d < 4 && sealed; d++) {
+            int x = cx[i] + dirs[d][0], y = cy[i] + dirs[d][1];
+            if (!blocks_box(x, y) && overlay_map[y][x] == OVERLAY_BOX) mark_box_dead(x, y);
+        }
+    }
+    return sealed;
+}
+
+// 箱子被推到 (x,y) 后检查死锁：静态死格、冻结在目标点以外、封死了空的目标点。
+// 只看这个箱子、和它挨着的一串箱子以及旁边的小块封闭区域。返回是否发现了新的死锁。
+static bool check_deadlock(int x, int y) {
+    bool found = false;
+    if (base_map[y][x] != BASE_TARGET && dead_square[y][x]) {
+        mark_box_dead(x, y);
+        found = true;
+    }
+    nr_frozen = 0;
+    if (is_frozen(x, y)) {
+        // 冻结的一组箱子里只要有一个不在目标点上就是死锁
+        bool off_target = false;
+        for (int i = 0; i < nr_frozen; i++) {
+            off_target |= base_map[frozen_y[i]][frozen_x[i]] != BASE_TARGET;
+        }
+        for (int i = 0; i < nr_frozen && off_target; i++) {
+            if (base_map[frozen_y[i]][frozen_x[i]] != BASE_TARGET) mark_box_dead(frozen_x[i], frozen_y[i]);
+        }
+        found |= off_target;
+    }
+    static const int dirs[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+    for (int d = 0; d < 4; d++) {
+        int nx = x + dirs[d][0], ny = y + dirs[d][1];
+        if (blocks_box(nx, ny) || overlay_map[ny][nx] != OVERLAY_NONE) continue;
+        found |= sealed_corral(nx, ny);
+    }
+    return found;
+}
+
+#ifdef __ISA_NATIVE__
+// 逐关检查外部关卡包，规则和 tools/pack 打包时相同。合法返回 NULL，否则打印是哪一关并返回原因
+static const char *check_level_pack(const uint8_t *pack, size_t size) {
+    int n = levelpack_count(pack, size);
+    if (n == 0) return "bad header";
+    for (int i = 0; i < n; i++) {
+        const uint8_t *level = levelpack_level(pack, size, i);
+        const char *err = level ? levelpack_check(level) : "truncated";
+        if (err) {
+            printf("第 %d 关不合法\n", i + 1);
+            return err;
+        }
+    }
+    return NULL;
+}
+#endif
+
+// 打开关卡包。native 下设置了 PUSH_BOX_LEVELS 时直接 mmap 这个文件，
+// 包头或任何一关不合法就退回内置的关卡包
+static void open_level_pack() {
+    level_pack = levelpack_builtin;
+    level_pack_size = levelpack_builtin_size;
+#ifdef __ISA_NATIVE__
+    const char *path = getenv("PUSH_BOX_LEVELS");
+    int fd = path ? open(path, O_RDONLY) : -1;
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        const uint8_t *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const char *err = p != MAP_FAILED ? check_level_pack(p, st.st_size) : "mmap failed";
+        if (!err) {
+            level_pack = p;
+            level_pack_size = st.st_size;
+        } else {
+            printf("%s 不是可用的关卡包（%s），使用内置关卡\n", path, err);
+            if (p != MAP_FAILED) munmap((void *)p, st.st_size);
+        }
+    }
+    if (fd >= 0) close(fd);
+#endif
+    level_count = levelpack_count(level_pack, level_pack_size);
+}
+
+// 载入关卡包里的第 index 关并重置游戏状态，关卡不存在或不合法（见 levelpack_check）时返回 false
+static bool load_level(int index) {
+    const uint8_t *level = levelpack_level(level_pack, level_pack_size, index);
+    if (!level || levelpack_check(level)) return false;
+    level_index = index;
+    level_w = level[0];
+    level_h = level[1];
+    for (int y = 0; y < GRID_MAX; y++) {
+        for (int x = 0; x < GRID_MAX; x++) {
+            int cell = x < level_w && y < level_h ? levelpack_cell(level, y * level_w + x) : BASE_WALL;
+            base_map[y][x] = (BaseType)(cell & 3);
+            overlay_map[y][x] = (OverlayType)(cell >> 2);
+            box_dead[y][x] = 0;
+        }
+    }
+    memset(dirty, 0, sizeof(dirty));
+    nr_dirty = 0;
+    redraw_all = true;
+    game_state = PLAYING;
+    moves = 0;
+    boxes_on_target = 0;
+    total_targets = 0;
+    hint_pos = -1;
+    log_len = log_end = 0;
     
     // 找到玩家初始位置和目标点数量
-    for (int y = 0; y < GRID_SIZE; y++) {
-        for (int x = 0; x < GRID_SIZE; x++) {
+    for (int y = 0; y < level_h; y++) {
+        for (int x = 0; x < level_w; x++) {
             if (overlay_map[y][x] == OVERLAY_PLAYER) {
                 player_x = x;
                 player_y = y;
@@ -141,9 +343,18 @@ static void init_game() {
         }
     }
     
+    // 静态死格，并检查初始局面里的箱子（这些标记不会被撤销，不留记录）
+    sokoban_dead_squares(&base_map[0][0], GRID_MAX, level_h, &dead_square[0][0]);
+    for (int y = 0; y < level_h; y++) {
+        for (int x = 0; x < level_w; x++) {
+            if (overlay_map[y][x] == OVERLAY_BOX) check_deadlock(x, y);
+        }
+    }
+    dead_len = 0;
+    
     // 计算网格在屏幕上的位置（确保在屏幕范围内）
-    int grid_total_width = GRID_SIZE * TILE_SIZE;
-    int grid_total_height = GRID_SIZE * TILE_SIZE;
+    int grid_total_width = level_w * TILE_SIZE;
+    int grid_total_height = level_h * TILE_SIZE;
     
     grid_offset_x = (screen_width - grid_total_width) / 2;
     grid_offset_y = (screen_height - grid_total_height) / 2;
@@ -151,6 +362,33 @@ static void init_game() {
     // 确保偏移不为负（屏幕小于网格时左上角对齐）
     grid_offset_x = (grid_offset_x < 0) ? 0 : grid_offset_x;
     grid_offset_y = (grid_offset_y < 0) ? 0 : grid_offset_y;
+    
+    printf("第 %d/%d 关\n", index + 1, level_count);
+    return true;
+}
+
+// 切换到相对当前关卡 step 关的关卡（首尾相接）
+static void switch_level(int step) {
+    if (level_count == 0) return;
+    load_level(((level_index + step) % level_count + level_count) % level_count);
+}
+
+// 初始化游戏
+static void init_game() {
+    // 获取屏幕尺寸
+    AM_GPU_CONFIG_T gpu_cfg = io_read(AM_GPU_CONFIG);
+    screen_width = gpu_cfg.width;
+    screen_height = gpu_cfg.height;
+    
+    // 初始化缓冲区
+    init_buffers();
+    
+    // 打开关卡包，载入第一关
+    open_level_pack();
+    if (!load_level(0)) {
+        printf("关卡包里没有可用的关卡\n");
+        halt(1);
+    }
 }
 
 // 获取基础格子颜色
@@ -162,14 +400,14 @@ static uint32_t get_base_color(int x, int y) {
     }
 }
 
-// 绘制单个格子（只绘制基础颜色）
-static void draw_base_tile(int x, int y) {
+// 绘制单个格子：底色和黑色边框，再叠上箱子或玩家，在 tile_buf 里合成好一次画到屏幕
+static void draw_cell(int x, int y) {
     if (!tile_buf) return; // 缓冲区分配失败则返回
     
     int tile_screen_x = grid_offset_x + x * TILE_SIZE;
     int tile_screen_y = grid_offset_y + y * TILE_SIZE;
     
-    // 检查绘制区域是否在屏幕内
+    // 检查绘制区域是否在屏幕内（跳过屏幕外的格子）
     if (!is_drawable(tile_screen_x, tile_screen_y, TILE_SIZE, TILE_SIZE)) {
         return;
     }
@@ -190,105 +428,40 @@ static void draw_base_tile(int x, int y) {
         tile_buf[i * TILE_SIZE + TILE_SIZE - 1] = border_color;  // 右边框
     }
     
-    // 绘制到屏幕
-    io_write(AM_GPU_FBDRAW, tile_screen_x, tile_screen_y, tile_buf, TILE_SIZE, TILE_SIZE, false);
-}
-
-// 绘制玩家（叠加在基础格子上）
-static void draw_player(int x, int y) {
-    if (!player_buf) return; // 缓冲区分配失败则返回
-    
-    // 先绘制基础格子
-    draw_base_tile(x, y);
-    
-    int player_size = TILE_SIZE / 2;
-    int player_screen_x = grid_offset_x + x * TILE_SIZE + (TILE_SIZE - player_size) / 2;
-    int player_screen_y = grid_offset_y + y * TILE_SIZE + (TILE_SIZE - player_size) / 2;
-    
-    // 检查绘制区域是否在屏幕内
-    if (!is_drawable(player_screen_x, player_screen_y, player_size, player_size)) {
-        return;
-    }
-    
-    // 填充玩家颜色
-    for (int i = 0; i < player_size * player_size; i++) {
-        player_buf[i] = COLOR_PLAYER;
-    }
-    
-    io_write(AM_GPU_FBDRAW, player_screen_x, player_screen_y, player_buf, player_size, player_size, false);
-}
-
-// 绘制箱子（叠加在基础格子上）
-static void draw_box(int x, int y) {
-    if (!box_buf) return; // 缓冲区分配失败则返回
-    
-    // 先绘制基础格子
-    draw_base_tile(x, y);
-    
-    int box_size = TILE_SIZE * 3 / 4;
-    int box_screen_x = grid_offset_x + x * TILE_SIZE + (TILE_SIZE - box_size) / 2;
-    int box_screen_y = grid_offset_y + y * TILE_SIZE + (TILE_SIZE - box_size) / 2;
-    
-    // 检查绘制区域是否在屏幕内
-    if (!is_drawable(box_screen_x, box_screen_y, box_size, box_size)) {
-        return;
+    // 叠加元素画在格子中央：玩家为半个格子大小，箱子为3/4个格子大小
+    int size = 0;
+    switch (overlay_map[y][x]) {
+        case OVERLAY_BOX:
+            size = TILE_SIZE * 3 / 4;
+            // 箱子颜色：死锁为灰色，在目标点上为橙色，否则为棕色
+            color = box_dead[y][x] ? COLOR_BOX_DEAD :
+                    (base_map[y][x] == BASE_TARGET) ? COLOR_BOX_ON_TARGET : COLOR_BOX;
+            break;
+        case OVERLAY_PLAYER:
+            size = TILE_SIZE / 2;
+            color = COLOR_PLAYER;
+            break;
+        default:
+            break; // 无叠加元素，只显示基础格子
     }
-    
-    // 箱子颜色：在目标点上为橙色，否则为棕色
-    uint32_t color = (base_map[y][x] == BASE_TARGET) ? COLOR_BOX_ON_TARGET : COLOR_BOX;
-    for (int i = 0; i < box_size * box_size; i++) {
-        box_buf[i] = color;
+    int offset = (TILE_SIZE - size) / 2;
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            tile_buf[(offset + i) * TILE_SIZE + offset + j] = color;
+        }
     }
     
-    io_write(AM_GPU_FBDRAW, box_screen_x, box_screen_y, box_buf, box_size, box_size, false);
+    // 绘制到屏幕
+    io_write(AM_GPU_FBDRAW, tile_screen_x, tile_screen_y, tile_buf, TILE_SIZE, TILE_SIZE, false);
 }
 
-// 绘制整个地图
-static void draw_map() {
-    // 清空屏幕（黑色）- 根据屏幕尺寸动态分配缓冲区
-    int clear_width = screen_width;
-    int clear_height = screen_height;
-    
-    // 每次清理一行，避免大内存分配
-    uint32_t *row_buf = (uint32_t*)malloc(clear_width * sizeof(uint32_t));
-    if (row_buf) {
-        memset(row_buf, 0, clear_width * sizeof(uint32_t));
-        
-        for (int y = 0; y < clear_height; y++) {
-            io_write(AM_GPU_FBDRAW, 0, y, row_buf, clear_width, 1, false);
-        }
-        free(row_buf);
-    }
-    
-    // 绘制每个格子
-    for (int y = 0; y < GRID_SIZE; y++) {
-        for (int x = 0; x < GRID_SIZE; x++) {
-            // 检查格子是否在屏幕可见范围内
-            int tile_screen_x = grid_offset_x + x * TILE_SIZE;
-            int tile_screen_y = grid_offset_y + y * TILE_SIZE;
-            if (!is_drawable(tile_screen_x, tile_screen_y, TILE_SIZE, TILE_SIZE)) {
-                continue; // 跳过屏幕外的格子
-            }
-            
-            // 先绘制基础格子
-            draw_base_tile(x, y);
-            
-            // 再绘制叠加元素
-            switch (overlay_map[y][x]) {
-                case OVERLAY_BOX:
-                    draw_box(x, y);
-                    break;
-                case OVERLAY_PLAYER:
-                    draw_player(x, y);
-                    break;
-                default:
-                    break; // 无叠加元素，只显示基础格子
-            }
-        }
+// 清空屏幕（黑色），每次画 CLEAR_ROWS 行
+static void clear_screen() {
+    if (!clear_buf) return;
+    for (int y = 0; y < screen_height; y += CLEAR_ROWS) {
+        int rows = screen_height - y < CLEAR_ROWS ? screen_height - y : CLEAR_ROWS;
+        io_write(AM_GPU_FBDRAW, 0, y, clear_buf, screen_width, rows, false);
     }
-    
-    // 刷新显示
-    io_write(AM_GPU_FBDRAW, 0, 0, NULL, 0, 0, true);
 }
 
 // 绘制单个字符
@@ -445,18 +618,30 @@ static void draw_char(int x, int y, char c, uint32_t color) {
 
 // 绘制游戏信息
 static void draw_info() {
+    static int last_x, last_len; // 上次画的步数的位置和位数，变短时先擦掉
+    
     // 显示步数
     char num_str[10];
     snprintf(num_str, sizeof(num_str), "%d", moves); // 使用snprintf避免缓冲区溢出
     int num_len = strlen(num_str);
     
     // 计算数字显示位置（确保在屏幕内）
-    int info_x = grid_offset_x + (GRID_SIZE * TILE_SIZE - num_len * 10) / 2;
+    int info_x = grid_offset_x + (level_w * TILE_SIZE - num_len * 10) / 2;
     int info_y = grid_offset_y - 20;
     
     // 确保信息显示在屏幕内
     if (info_y < 0) info_y = 5; // 顶部边界调整
     
+    // 位数变少时擦掉上次的数字（整屏重画后上次的数字已经清掉了）
+    if (redraw_all) last_len = 0;
+    if (num_len < last_len) {
+        for (int i = 0; i < last_len; i++) {
+            draw_char(last_x + i * 10, info_y, ' ', COLOR_WHITE);
+        }
+    }
+    last_x = info_x;
+    last_len = num_len;
+    
     // 逐个绘制数字
     for (int i = 0; i < num_len && i < 9; i++) { // 限制最大长度，避免越界
         draw_char(info_x + i * 10, info_y, num_str[i], COLOR_WHITE);
@@ -465,7 +650,7 @@ static void draw_info() {
     // 游戏胜利时显示胜利提示
     if (game_state == WON) {
         char win_msg[] = "YOU WIN";
-        int msg_x = grid_offset_x + (GRID_SIZE * TILE_SIZE - strlen(win_msg) * 10) / 2;
+        int msg_x = grid_offset_x + (level_w * TILE_SIZE - strlen(win_msg) * 10) / 2;
         int msg_y = 30;
         
         // 确保胜利提示在屏幕内
@@ -479,6 +664,35 @@ static void draw_info() {
     }
 }
 
+// 绘制一帧：关卡开始时整屏重画，之后只画改动过的格子和步数，没有改动时直接返回
+static void render() {
+    if (redraw_all) {
+        clear_screen();
+        for (int y = 0; y < level_h; y++) {
+            for (int x = 0; x < level_w; x++) {
+                draw_cell(x, y);
+            }
+        }
+        info_dirty = true;
+    } else if (nr_dirty > 0) {
+        for (int y = 0; y < level_h; y++) {
+            for (int x = 0; x < level_w; x++) {
+                if (dirty[y][x]) draw_cell(x, y);
+            }
+        }
+    } else if (!info_dirty) {
+        return;
+    }
+    if (info_dirty) draw_info();
+    memset(dirty, 0, sizeof(dirty));
+    nr_dirty = 0;
+    redraw_all = false;
+    info_dirty = false;
+    
+    // 刷新显示
+    io_write(AM_GPU_FBDRAW, 0, 0, NULL, 0, 0, true);
+}
+
 // 微秒级延迟函数
 static void delay_us(unsigned int us) {
     // 使用更可靠的延迟方式，避免计数器溢出
@@ -490,7 +704,7 @@ static void delay_us(unsigned int us) {
 
 // 检查移动是否有效（不超出边界且不是墙壁）
 static bool can_move(int x, int y) {
-    return x >= 0 && x < GRID_SIZE && y >= 0 && y < GRID_SIZE && base_map[y][x] != BASE_WALL;
+    return x >= 0 && x < level_w && y >= 0 && y < level_h && base_map[y][x] != BASE_WALL;
 }
 
 // 检查箱子是否可以被推动
@@ -500,22 +714,21 @@ static bool can_push_box(int x, int y, int dx, int dy) {
     return can_move(nx, ny) && overlay_map[ny][nx] == OVERLAY_NONE;
 }
 
-// 移动玩家
-static void move_player(int dx, int dy) {
-    if (game_state != PLAYING) return;
-    
+// 移动玩家，返回 -1 表示走不动，否则返回是否推动了箱子
+static int step_player(int dx, int dy) {
     int new_x = player_x + dx;
     int new_y = player_y + dy;
     
     // 检查是否可以移动
     if (!can_move(new_x, new_y)) {
-        return;
+        return -1;
     }
     
     // 如果目标位置是箱子，尝试推动它
-    if (overlay_map[new_y][new_x] == OVERLAY_BOX) {
+    bool pushed = overlay_map[new_y][new_x] == OVERLAY_BOX;
+    if (pushed) {
         if (!can_push_box(new_x, new_y, dx, dy)) {
-            return; // 无法推动箱子
+            return -1; // 无法推动箱子
         }
         
         // 更新箱子移动前的计数
@@ -524,8 +737,11 @@ static void move_player(int dx, int dy) {
         }
         
         // 推动箱子
+        mark_dirty(new_x + dx, new_y + dy);
         overlay_map[new_y + dy][new_x + dx] = OVERLAY_BOX;
         overlay_map[new_y][new_x] = OVERLAY_NONE;
+        if (box_dead[new_y][new_x]) log_dead(DEAD_RESTORE | (new_y * GRID_MAX + new_x));
+        box_dead[new_y][new_x] = 0;
         
         // 更新箱子移动后的计数
         if (base_map[new_y + dy][new_x + dx] == BASE_TARGET) {
@@ -534,20 +750,181 @@ static void move_player(int dx, int dy) {
     }
     
     // 移动玩家
+    mark_dirty(player_x, player_y);
+    mark_dirty(new_x, new_y);
     overlay_map[player_y][player_x] = OVERLAY_NONE;
     player_x = new_x;
     player_y = new_y;
     overlay_map[player_y][player_x] = OVERLAY_PLAYER;
     
+    // 玩家站好以后再检查死锁（封闭区域的判断要看玩家在哪）
+    if (pushed && check_deadlock(new_x + dx, new_y + dy)) {
+        printf("死锁：灰色的箱子再也推不到目标点了\n");
+    }
+    if (pushed) log_dead(DEAD_END);
+    
     // 增加步数（限制最大值，防止溢出）
     if (moves < INT_MAX - 1) {
         moves++;
     }
+    info_dirty = true;
     
     // 检查是否获胜（所有目标点都有箱子）
     if (boxes_on_target == total_targets) {
         game_state = WON;
     }
+    return pushed;
+}
+
+// 把移动日志按 LURD 格式输出（小写为走，大写为推）
+static void print_lurd() {
+    static const char lurd[2][4] = { { 'l', 'u', 'r', 'd' }, { 'L', 'U', 'R', 'D' } };
+    for (int i = 0; i < log_len; i++) {
+        putch(lurd[(move_log[i] & LOG_PUSH) != 0][move_log[i] & 3]);
+    }
+    putch('\n');
+}
+
+// 在移动日志末尾追加一步，缓冲区满了就翻倍
+static void log_step(uint8_t step) {
+    if (log_len == log_cap) {
+        int cap = log_cap ? log_cap * 2 : 256;
+        uint8_t *buf = (uint8_t*)malloc(cap);
+        if (!buf) {
+            printf("内存不足，清空撤销记录\n");
+            log_len = log_end = 0;
+            dead_len = 0;
+            return;
+        }
+        if (move_log) {
+            memcpy(buf, move_log, log_len);
+            free(move_log);
+        }
+        move_log = buf;
+        log_cap = cap;
+    }
+    move_log[log_len++] = step;
+    log_end = log_len; // 走了新的一步，撤销过的步不能再重做
+}
+
+// 死锁记录入栈，缓冲区满了就翻倍。内存不够时和移动日志一起清空，之后不能撤销到这之前
+static void log_dead(uint16_t entry) {
+    if (dead_len == dead_cap) {
+        int cap = dead_cap ? dead_cap * 2 : 256;
+        uint16_t *buf = (uint16_t*)malloc(cap * sizeof(uint16_t));
+        if (!buf) {
+            printf("内存不足，清空撤销记录\n");
+            log_len = log_end = 0;
+            dead_len = 0;
+            return;
+        }
+        if (dead_log) {
+            memcpy(buf, dead_log, dead_len * sizeof(uint16_t));
+            free(dead_log);
+        }
+        dead_log = buf;
+        dead_cap = cap;
+    }
+    dead_log[dead_len++] = entry;
+}
+
+// 撤销最近一次推动留下的死锁标记：新标记的清掉，被推箱子原来的标记放回去
+static void undo_dead_marks() {
+    if (dead_len > 0 && dead_log[dead_len - 1] == DEAD_END) dead_len--;
+    while (dead_len > 0 && dead_log[dead_len - 1] != DEAD_END) {
+        uint16_t entry = dead_log[--dead_len];
+        int cell = entry & ~DEAD_RESTORE, x = cell % GRID_MAX, y = cell / GRID_MAX;
+        box_dead[y][x] = (entry & DEAD_RESTORE) != 0;
+        mark_dirty(x, y);
+    }
+}
+
+// 玩家走一步并记入移动日志
+static void move_player(int dx, int dy) {
+    if (game_state != PLAYING) return;
+    
+    int dir = dx < 0 ? DIR_LEFT : dy < 0 ? DIR_UP : dx > 0 ? DIR_RIGHT : DIR_DOWN;
+    int pushed = step_player(dx, dy);
+    if (pushed < 0) return;
+    log_step(dir | (pushed ? LOG_PUSH : 0));
+    
+    if (game_state == WON) {
+        printf("用了 %d 步：", moves);
+        print_lurd();
+    }
+}
+
+// 撤销一步：玩家退回去，推过箱子就把箱子拉回来。胜利后也可以撤销，回到游戏中
+static void undo_move() {
+    if (log_len == 0) return;
+    if (game_state == WON) {
+        game_state = PLAYING;
+        redraw_all = true; // 擦掉胜利提示
+    }
+    
+    uint8_t step = move_log[--log_len];
+    int dx = dir_dx[step & 3], dy = dir_dy[step & 3];
+    int old_x = player_x - dx, old_y = player_y - dy;
+    
+    mark_dirty(player_x, player_y);
+    mark_dirty(old_x, old_y);
+    overlay_map[player_y][player_x] = OVERLAY_NONE;
+    if (step & LOG_PUSH) {
+        int box_x = player_x + dx, box_y = player_y + dy;
+        mark_dirty(box_x, box_y);
+        if (base_map[box_y][box_x] == BASE_TARGET) boxes_on_target--;
+        if (base_map[player_y][player_x] == BASE_TARGET) boxes_on_target++;
+        overlay_map[box_y][box_x] = OVERLAY_NONE;
+        overlay_map[player_y][player_x] = OVERLAY_BOX;
+    }
+    player_x = old_x;
+    player_y = old_y;
+    overlay_map[player_y][player_x] = OVERLAY_PLAYER;
+    if (step & LOG_PUSH) undo_dead_marks();
+    
+    if (moves > 0) moves--;
+    info_dirty = true;
+}
+
+// 重做一步撤销过的步
+static void redo_move() {
+    if (game_state != PLAYING || log_len == log_end) return;
+    
+    uint8_t step = move_log[log_len];
+    if (step_player(dir_dx[step & 3], dir_dy[step & 3]) < 0) return;
+    log_len++;
+    
+    if (game_state == WON) {
+        printf("用了 %d 步：", moves);
+        print_lurd();
+    }
+}
+
+static void show_hint() {
+    if (game_state != PLAYING) return;
+    if (hint_pos < 0 || hint_moves[hint_pos] == '\0') {
+        SolveStats stats;
+        uint64_t start = io_read(AM_TIMER_UPTIME).us;
+        SolveResult result = sokoban_solve(&base_map[0][0], &overlay_map[0][0], GRID_MAX, level_h,
+                                           HINT_MAX_NODES, hint_moves, sizeof(hint_moves), &stats);
+        uint64_t us = io_read(AM_TIMER_UPTIME).us - start;
+        int rate = us > 0 ? (int)(stats.generated * 1000000 / us) : 0;
+        printf("提示：展开 %d 个节点，生成 %d 个，用时 %d 毫秒（生成 %d 节点/秒），内存 %d KB\n",
+               (int)stats.expanded, (int)stats.generated, (int)(us / 1000), rate, (int)(stats.memory / 1024));
+        if (result != SOLVE_OK || stats.moves >= HINT_MAX_MOVES) {
+            printf(result == SOLVE_NONE ? "当前局面无解，请重新开始\n" : "没有找到解\n");
+            hint_pos = -1;
+            return;
+        }
+        printf("最优解还需推动 %d 次，共 %d 步\n", stats.pushes, stats.moves);
+        hint_pos = 0;
+    }
+    switch (hint_moves[hint_pos++]) {
+        case 'l': case 'L': move_player(-1, 0); break;
+        case 'u': case 'U': move_player(0, -1); break;
+        case 'r': case 'R': move_player(1, 0);  break;
+        case 'd': case 'D': move_player(0, 1);  break;
+    }
 }
 
 // 处理用户输入
@@ -556,10 +933,17 @@ static void handle_input() {
     if (!key_event.keydown) return;
     
     switch (key_event.keycode) {
-        case AM_KEY_W:  move_player(0, -1); break; // 上
-        case AM_KEY_S:  move_player(0, 1);  break; // 下
-        case AM_KEY_A:  move_player(-1, 0); break; // 左
-        case AM_KEY_D:  move_player(1, 0);  break; // 右
+        case AM_KEY_W:  move_player(0, -1); hint_pos = -1; break; // 上
+        case AM_KEY_S:  move_player(0, 1);  hint_pos = -1; break; // 下
+        case AM_KEY_A:  move_player(-1, 0); hint_pos = -1; break; // 左
+        case AM_KEY_D:  move_player(1, 0);  hint_pos = -1; break; // 右
+        case AM_KEY_H:  show_hint(); break; // 提示
+        case AM_KEY_Z:  undo_move(); hint_pos = -1; break; // 撤销
+        case AM_KEY_Y:  redo_move(); hint_pos = -1; break; // 重做
+        case AM_KEY_E:  print_lurd(); break; // 输出走过的步（LURD）
+        case AM_KEY_R:  switch_level(0);  break; // 重新开始本关
+        case AM_KEY_N:  switch_level(1);  break; // 下一关
+        case AM_KEY_P:  switch_level(-1); break; // 上一关
         case AM_KEY_Q:  game_state = EXITED; break; // 退出
     }
 }
@@ -570,23 +954,12 @@ static void game_loop() {
         // 处理输入
         handle_input();
         
-        // 绘制游戏
-        draw_map();
-        draw_info();
+        // 绘制游戏（只画有变化的部分）
+        render();
         
-        // 控制帧率，使用定时器延迟而非忙循环计数
+        // 控制帧率，使用定时器延迟而非忙循环计数。胜利后照常处理输入：
+        // 移动和重做不起作用，可以撤销、重新开始、切换关卡或退出
         delay_us(FRAME_DELAY);
-        
-        // 胜利后等待按Q退出
-        if (game_state == WON) {
-            while (1) {
-                AM_INPUT_KEYBRD_T key_event = io_read(AM_INPUT_KEYBRD);
-                if (key_event.keydown && key_event.keycode == AM_KEY_Q) {
-                    game_state = EXITED;
-                    break;
-                }
-            }
-        }
     }
 }
 
@@ -599,6 +972,9 @@ int main() {
     // 显示游戏说明
     printf("推箱子游戏\n");
     printf("使用WASD移动\n");
+    printf("按H提示下一步\n");
+    printf("按Z撤销，按Y重做，按E输出走过的步（LURD）\n");
+    printf("按N/P切换关卡，按R重新开始\n");
     printf("将所有箱子推到目标点上获胜\n");
     printf("按Q退出游戏\n");
     
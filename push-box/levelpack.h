@@ -0,0 +1,73 @@
+#ifndef PUSH_BOX_LEVELPACK_H__
+#define PUSH_BOX_LEVELPACK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sokoban.h"
+
+// 关卡包格式：文件头、count 个关卡偏移、各关卡数据依次排列，所有字段均为小端序。
+// 构建时由 tools/pack 把 levels/ 下的 XSB 文件打包，生成的 levels.c 编进游戏；
+// native 下设置 PUSH_BOX_LEVELS 环境变量时直接 mmap 这个文件，不做任何拷贝。
+// 每个关卡是宽、高各一个字节，后面每格4位（base | overlay << 2），两格一字节，先低4位后高4位，
+// 按行存放。10x10 的关卡占 52 字节，加上偏移一共 56 字节。
+
+#define LEVELPACK_MAGIC    0x4b504b53u  // "SKPK"
+#define LEVELPACK_VERSION  1
+#define LEVELPACK_MAX_DIM  24           // 游戏能装下的最大宽高
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;     // 关卡数，后面紧跟 uint32_t offset[count]（相对包的开头）
+} __attribute__((packed)) levelpack_header_t;
+
+_Static_assert(sizeof(levelpack_header_t) == 8, "level pack header must be 8 bytes");
+
+// 编进游戏的关卡包（构建时生成的 levels.c）
+extern const uint8_t levelpack_builtin[];
+extern const uint32_t levelpack_builtin_size;
+
+// 检查包头和偏移表，返回关卡数，不合法返回 0
+static inline int levelpack_count(const uint8_t *pack, size_t size) {
+    const levelpack_header_t *hdr = (const levelpack_header_t *)pack;
+    if (size < sizeof(*hdr) || hdr->magic != LEVELPACK_MAGIC || hdr->version != LEVELPACK_VERSION) return 0;
+    if (size < sizeof(*hdr) + hdr->count * sizeof(uint32_t)) return 0;
+    return hdr->count;
+}
+
+// 第 index 个关卡的数据（宽、高、格子），越界或数据不完整返回 NULL
+static inline const uint8_t *levelpack_level(const uint8_t *pack, size_t size, int index) {
+    if (index < 0 || index >= levelpack_count(pack, size)) return NULL;
+    const uint8_t *p = pack + sizeof(levelpack_header_t) + index * sizeof(uint32_t);
+    uint32_t off = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    if (off + 2 > size) return NULL;
+    const uint8_t *level = pack + off;
+    if (off + 2 + (level[0] * level[1] + 1) / 2 > size) return NULL;
+    return level;
+}
+
+// 关卡第 i 格的 base | overlay << 2
+static inline int levelpack_cell(const uint8_t *level, int i) {
+    return level[2 + i / 2] >> (i % 2 * 4) & 0xf;
+}
+
+// 检查关卡能不能玩：大小、格子取值、恰好一个玩家、箱子数与目标点数相同且不超过 SOKO_MAX_BOXES。
+// tools/pack 打包时和游戏打开外部关卡包时用同一套规则，合法返回 NULL，否则返回原因
+static inline const char *levelpack_check(const uint8_t *level) {
+    int w = level[0], h = level[1];
+    if (w == 0 || h == 0 || w > LEVELPACK_MAX_DIM || h > LEVELPACK_MAX_DIM) return "bad size";
+    int players = 0, boxes = 0, targets = 0;
+    for (int i = 0; i < w * h; i++) {
+        int cell = levelpack_cell(level, i), base = cell & 3, overlay = cell >> 2;
+        if (base > BASE_TARGET || overlay > OVERLAY_PLAYER) return "bad cell";
+        players += overlay == OVERLAY_PLAYER;
+        boxes += overlay == OVERLAY_BOX;
+        targets += base == BASE_TARGET;
+    }
+    if (players != 1) return "needs exactly one player";
+    if (boxes != targets || boxes == 0) return "box and target counts differ";
+    if (boxes > SOKO_MAX_BOXES) return "too many boxes";
+    return NULL;
+}
+
+#endif
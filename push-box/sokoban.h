@@ -0,0 +1,52 @@
+#ifndef PUSH_BOX_SOKOBAN_H__
+#define PUSH_BOX_SOKOBAN_H__
+
+// 地图表示和求解器接口：游戏本体（box.c）和主机端工具（tools/）共用。
+// 地图按行存放，第 y 行第 x 列为 map[y * width + x]。
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 游戏元素枚举 - 分离基础元素和叠加元素
+typedef enum {
+    BASE_FLOOR,    // 基础地板
+    BASE_WALL,     // 基础墙壁
+    BASE_TARGET    // 基础目标点
+} BaseType;
+
+typedef enum {
+    OVERLAY_NONE,  // 无叠加元素
+    OVERLAY_BOX,   // 箱子
+    OVERLAY_PLAYER // 玩家
+} OverlayType;
+
+// 求解器支持的最大地图和箱子数
+#define SOKO_MAX_CELLS 4096
+#define SOKO_MAX_BOXES 32
+
+// 方向按 LURD 顺序编号，相反方向为 d ^ 2
+enum { DIR_LEFT, DIR_UP, DIR_RIGHT, DIR_DOWN };
+
+typedef enum {
+    SOLVE_OK,         // 找到了最少推动次数的解
+    SOLVE_NONE,       // 无解
+    SOLVE_LIMIT,      // 达到节点上限，不确定是否有解
+    SOLVE_INVALID     // 地图不合法（没有玩家、箱子数与目标数不同、太大等）
+} SolveResult;
+
+typedef struct {
+    uint64_t expanded;   // 展开的节点数
+    uint64_t generated;  // 生成的节点数（含重复）
+    size_t memory;       // 求解器占用的内存（字节）
+    int pushes, moves;   // 解的推动次数和总步数
+} SolveStats;
+
+// 按推动次数最优的 A* 搜索。解以 LURD 字符串写入 lurd（小写为走，大写为推），
+// lurd_size 不够时截断（stats->moves 仍为完整长度）。max_nodes 为保存的节点数上限。
+SolveResult sokoban_solve(const BaseType *base, const OverlayType *overlay, int width, int height,
+                          int max_nodes, char *lurd, int lurd_size, SolveStats *stats);
+
+// 静态死格：箱子放上去以后无论怎么推都到不了任何目标点的格子（dead[i] 为1），墙壁也记为死格
+void sokoban_dead_squares(const BaseType *base, int width, int height, uint8_t *dead);
+
+#endif
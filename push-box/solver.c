@@ -0,0 +1,573 @@
+// 推箱子求解器：按推动次数最优的 A* 搜索
+// - 状态是箱子位置（升序数组）加规范化的玩家位置（玩家能走到的区域里下标最小的格子），
+//   玩家在同一连通区域内怎么走都算同一状态，展开时只枚举推动
+// - 状态哈希用 Zobrist：每格一个箱子随机数、一个玩家随机数，推动一次只异或四个数
+// - 开放地址的置换表兼作关闭表，节点按结构数组存放
+// - 静态死格剪枝；下界是箱子与目标的最小代价匹配（匈牙利算法），代价为不考虑其它箱子时的
+//   推动距离，由各目标反向拉箱子预先算出
+// 内部地图四周补一圈墙，这样越界检查和走出地图的情况都不用单独处理。
+#include <stdlib.h>
+#include <string.h>
+#include "sokoban.h"
+
+#define INF_DIST 0xffff    // 推不到
+#define INF_COST (1 << 24) // 匹配里推不到的代价，n 个相加不会溢出
+#define NO_NODE (-1)
+
+static const char lurd_chars[] = "lurd";
+
+typedef struct {
+    uint32_t key;  // (f << 16) | h，f 相同时优先展开下界小的
+    int32_t node;
+} OpenEntry;
+
+typedef struct {
+    int width, height;   // 补墙后的尺寸
+    int cells;
+    int off[4];
+    uint8_t *wall;
+    uint8_t *dead;
+    int nboxes;
+    uint16_t goals[SOKO_MAX_BOXES];
+    uint16_t *dist;      // dist[g * cells + c]：箱子从 c 推到第 g 个目标的最少推动次数
+    uint64_t *zbox, *zplayer;
+
+    // 节点
+    int count, cap, max_nodes;
+    uint16_t *boxes;     // 第 i 个节点的箱子为 boxes[i * nboxes ...]
+    uint64_t *hash;
+    int32_t *parent;
+    uint16_t *player;    // 规范化的玩家位置
+    uint16_t *g, *h;     // 已推动次数和下界
+    uint16_t *push;      // 得到该节点的推动：箱子原位置 * 4 + 方向
+
+    int32_t *table;      // 置换表，存节点下标，NO_NODE 为空
+    uint32_t mask;
+
+    OpenEntry *open;
+    int open_len, open_cap;
+
+    // 临时数组
+    uint8_t *occ;        // 当前展开节点的箱子
+    uint32_t *mark;      // 玩家可达标记（等于 stamp 为可达）
+    uint32_t stamp;
+    uint16_t *queue;
+    uint8_t *from;       // 还原走法时记录到达各格的方向
+
+    size_t memory;
+} Solver;
+
+// 只用 malloc/free，klib 里不一定有 calloc 和 realloc
+static void *solver_alloc(Solver *s, size_t size) {
+    s->memory += size;
+    void *p = malloc(size);
+    memset(p, 0, size);
+    return p;
+}
+
+static void *solver_grow(Solver *s, void *p, size_t old_size, size_t new_size) {
+    void *q = solver_alloc(s, new_size);
+    if (p) memcpy(q, p, old_size);
+    free(p);
+    s->memory -= old_size;
+    return q;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    // splitmix64
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// 从目标 goal 反向拉箱子，算出各格到该目标的推动距离。
+// 箱子从 a 推到 a+d 需要玩家站在 a-d，所以反过来从 b 拉到 b-d 要求 b-d 和 b-2d 都不是墙。
+static void pull_distances(const uint8_t *wall, int cells, const int *off, int goal, uint16_t *dist,
+                           uint16_t *queue) {
+    for (int i = 0; i < cells; i++) {
+        dist[i] = INF_DIST;
+    }
+    int head = 0, tail = 0;
+    dist[goal] = 0;
+    queue[tail++] = goal;
+    while (head < tail) {
+        int b = queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int a = b - off[d];
+            if (wall[a] || wall[a - off[d]] || dist[a] != INF_DIST) continue;
+            dist[a] = dist[b] + 1;
+            queue[tail++] = a;
+        }
+    }
+}
+
+// 把外部地图转换成补墙后的内部地图
+static void pad_walls(const BaseType *base, int width, int height, uint8_t *wall) {
+    int pw = width + 2;
+    memset(wall, 1, pw * (height + 2));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            wall[(y + 1) * pw + x + 1] = base[y * width + x] == BASE_WALL;
+        }
+    }
+}
+
+void sokoban_dead_squares(const BaseType *base, int width, int height, uint8_t *dead) {
+    int pw = width + 2, cells = pw * (height + 2);
+    int off[4] = { -1, -pw, 1, pw };
+    uint8_t *wall = malloc(cells);
+    uint16_t *dist = malloc(cells * sizeof(uint16_t));
+    uint16_t *queue = malloc(cells * sizeof(uint16_t));
+    uint8_t *live = malloc(cells);
+    memset(live, 0, cells);
+    pad_walls(base, width, height, wall);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (base[y * width + x] != BASE_TARGET) continue;
+            pull_distances(wall, cells, off, (y + 1) * pw + x + 1, dist, queue);
+            for (int i = 0; i < cells; i++) {
+                live[i] |= dist[i] != INF_DIST;
+            }
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            dead[y * width + x] = !live[(y + 1) * pw + x + 1];
+        }
+    }
+    free(wall);
+    free(dist);
+    free(queue);
+    free(live);
+}
+
+// 换一个新的标记值，相当于清空 mark
+static void new_stamp(Solver *s) {
+    if (++s->stamp == 0) {
+        memset(s->mark, 0, s->cells * sizeof(uint32_t));
+        s->stamp = 1;
+    }
+}
+
+// 从 start 出发标记玩家能走到的格子（箱子和墙挡路），返回其中下标最小的格子
+static int reach(Solver *s, int start) {
+    new_stamp(s);
+    int head = 0, tail = 0, min = start;
+    s->mark[start] = s->stamp;
+    s->queue[tail++] = start;
+    while (head < tail) {
+        int c = s->queue[head++];
+        if (c < min) min = c;
+        for (int d = 0; d < 4; d++) {
+            int n = c + s->off[d];
+            if (s->wall[n] || s->occ[n] || s->mark[n] == s->stamp) continue;
+            s->mark[n] = s->stamp;
+            s->queue[tail++] = n;
+        }
+    }
+    return min;
+}
+
+// 下界：箱子与目标的最小代价完美匹配（匈牙利算法，O(n^3)），推不到时返回 INF_COST 以上
+static int lower_bound(const Solver *s, const uint16_t *boxes) {
+    int n = s->nboxes;
+    int cost[SOKO_MAX_BOXES][SOKO_MAX_BOXES];
+    for (int i = 0; i < n; i++) {
+        int any = 0;
+        for (int j = 0; j < n; j++) {
+            int d = s->dist[j * s->cells + boxes[i]];
+            cost[i][j] = d == INF_DIST ? INF_COST : d;
+            any |= d != INF_DIST;
+        }
+        if (!any) return INF_COST;
+    }
+    // 行为箱子、列为目标，下标从1开始，p[j] 为匹配到目标 j 的箱子
+    int u[SOKO_MAX_BOXES + 1] = { 0 }, v[SOKO_MAX_BOXES + 1] = { 0 };
+    int p[SOKO_MAX_BOXES + 1] = { 0 }, way[SOKO_MAX_BOXES + 1] = { 0 };
+    int minv[SOKO_MAX_BOXES + 1];
+    uint8_t used[SOKO_MAX_BOXES + 1];
+    for (int i = 1; i <= n; i++) {
+        p[0] = i;
+        int j0 = 0;
+        for (int j = 0; j <= n; j++) {
+            minv[j] = 0x3fffffff;
+            used[j] = 0;
+        }
+        do {
+            used[j0] = 1;
+            int i0 = p[j0], delta = 0x3fffffff, j1 = 0;
+            for (int j = 1; j <= n; j++) {
+                if (used[j]) continue;
+                int cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    int total = 0;
+    for (int j = 1; j <= n; j++) {
+        total += cost[p[j] - 1][j - 1];
+    }
+    return total;
+}
+
+static void open_push(Solver *s, int node) {
+    if (s->open_len == s->open_cap) {
+        int cap = s->open_cap ? s->open_cap * 2 : 1024;
+        s->open = solver_grow(s, s->open, s->open_cap * sizeof(OpenEntry), cap * sizeof(OpenEntry));
+        s->open_cap = cap;
+    }
+    OpenEntry e = { (uint32_t)(s->g[node] + s->h[node]) << 16 | s->h[node], node };
+    int i = s->open_len++;
+    while (i > 0 && s->open[(i - 1) / 2].key > e.key) {
+        s->open[i] = s->open[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s->open[i] = e;
+}
+
+static OpenEntry open_pop(Solver *s) {
+    OpenEntry top = s->open[0], last = s->open[--s->open_len];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= s->open_len) break;
+        if (c + 1 < s->open_len && s->open[c + 1].key < s->open[c].key) c++;
+        if (s->open[c].key >= last.key) break;
+        s->open[i] = s->open[c];
+        i = c;
+    }
+    s->open[i] = last;
+    return top;
+}
+
+// 在置换表中查找状态，找不到返回 NO_NODE
+static int table_find(const Solver *s, uint64_t hash, const uint16_t *boxes, int player) {
+    for (uint32_t i = (uint32_t)hash & s->mask;; i = (i + 1) & s->mask) {
+        int node = s->table[i];
+        if (node == NO_NODE) return NO_NODE;
+        if (s->hash[node] == hash && s->player[node] == player &&
+            memcmp(s->boxes + node * s->nboxes, boxes, s->nboxes * sizeof(uint16_t)) == 0) {
+            return node;
+        }
+    }
+}
+
+static void table_insert(Solver *s, int node) {
+    uint32_t i = (uint32_t)s->hash[node] & s->mask;
+    while (s->table[i] != NO_NODE) {
+        i = (i + 1) & s->mask;
+    }
+    s->table[i] = node;
+}
+
+// 新增一个节点，容量不够时翻倍；置换表保持至多半满
+static int new_node(Solver *s) {
+    if (s->count == s->cap) {
+        int cap = s->cap * 2;
+        int nb = s->nboxes;
+        s->boxes = solver_grow(s, s->boxes, (size_t)s->cap * nb * 2, (size_t)cap * nb * 2);
+        s->hash = solver_grow(s, s->hash, s->cap * sizeof(uint64_t), cap * sizeof(uint64_t));
+        s->parent = solver_grow(s, s->parent, s->cap * sizeof(int32_t), cap * sizeof(int32_t));
+        s->player = solver_grow(s, s->player, s->cap * 2, cap * 2);
+        s->g = solver_grow(s, s->g, s->cap * 2, cap * 2);
+        s->h = solver_grow(s, s->h, s->cap * 2, cap * 2);
+        s->push = solver_grow(s, s->push, s->cap * 2, cap * 2);
+        s->cap = cap;
+    }
+    if ((uint32_t)(s->count + 1) * 2 > s->mask + 1) {
+        uint32_t size = (s->mask + 1) * 2;
+        s->memory -= (s->mask + 1) * sizeof(int32_t);
+        free(s->table);
+        s->table = solver_alloc(s, size * sizeof(int32_t));
+        memset(s->table, 0xff, size * sizeof(int32_t));
+        s->mask = size - 1;
+        for (int i = 0; i < s->count; i++) {
+            table_insert(s, i);
+        }
+    }
+    return s->count++;
+}
+
+// 从根节点重放推动序列，补上推动之间玩家的走法，写出 LURD 字符串
+static int write_solution(Solver *s, int node, int player, char *lurd, int lurd_size) {
+    int npushes = s->g[node];
+    uint16_t *pushes = malloc((npushes + 1) * sizeof(uint16_t));
+    for (int i = npushes; node != 0; node = s->parent[node]) {
+        pushes[--i] = s->push[node];
+    }
+    memset(s->occ, 0, s->cells);
+    for (int i = 0; i < s->nboxes; i++) {
+        s->occ[s->boxes[i]] = 1;
+    }
+    int len = 0;
+    for (int k = 0; k < npushes; k++) {
+        int b = pushes[k] >> 2, d = pushes[k] & 3;
+        int stand = b - s->off[d];
+        // 广度优先找到站位的最短路，再沿 from 倒推
+        new_stamp(s);
+        int head = 0, tail = 0;
+        s->mark[player] = s->stamp;
+        s->queue[tail++] = player;
+        while (head < tail && s->mark[stand] != s->stamp) {
+            int c = s->queue[head++];
+            for (int dd = 0; dd < 4; dd++) {
+                int n = c + s->off[dd];
+                if (s->wall[n] || s->occ[n] || s->mark[n] == s->stamp) continue;
+                s->mark[n] = s->stamp;
+                s->from[n] = dd;
+                s->queue[tail++] = n;
+            }
+        }
+        int steps = 0;
+        for (int c = stand; c != player; c -= s->off[s->from[c]]) {
+            steps++;
+        }
+        for (int c = stand, i = steps - 1; c != player; c -= s->off[s->from[c]], i--) {
+            if (len + i < lurd_size - 1) lurd[len + i] = lurd_chars[s->from[c]];
+        }
+        len += steps;
+        if (len < lurd_size - 1) lurd[len] = lurd_chars[d] - 'a' + 'A';
+        len++;
+        s->occ[b] = 0;
+        s->occ[b + s->off[d]] = 1;
+        player = b;
+    }
+    if (lurd_size > 0) lurd[len < lurd_size ? len : lurd_size - 1] = '\0';
+    free(pushes);
+    return len;
+}
+
+static void free_solver(Solver *s) {
+    free(s->wall);
+    free(s->dead);
+    free(s->dist);
+    free(s->zbox);
+    free(s->zplayer);
+    free(s->boxes);
+    free(s->hash);
+    free(s->parent);
+    free(s->player);
+    free(s->g);
+    free(s->h);
+    free(s->push);
+    free(s->table);
+    free(s->open);
+    free(s->occ);
+    free(s->mark);
+    free(s->queue);
+    free(s->from);
+}
+
+SolveResult sokoban_solve(const BaseType *base, const OverlayType *overlay, int width, int height,
+                          int max_nodes, char *lurd, int lurd_size, SolveStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (lurd_size > 0) lurd[0] = '\0';
+    int pw = width + 2, ph = height + 2;
+    if (width <= 0 || height <= 0 || pw * ph > SOKO_MAX_CELLS) return SOLVE_INVALID;
+
+    Solver solver = { 0 }, *s = &solver;
+    s->width = pw;
+    s->height = ph;
+    s->cells = pw * ph;
+    s->off[DIR_LEFT] = -1;
+    s->off[DIR_UP] = -pw;
+    s->off[DIR_RIGHT] = 1;
+    s->off[DIR_DOWN] = pw;
+    s->max_nodes = max_nodes;
+
+    // 找玩家、箱子和目标
+    int player = -1, nboxes = 0, ngoals = 0;
+    uint16_t root_boxes[SOKO_MAX_BOXES];
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int i = y * width + x, c = (y + 1) * pw + x + 1;
+            if (overlay[i] == OVERLAY_PLAYER) {
+                if (player >= 0) return SOLVE_INVALID;
+                player = c;
+            } else if (overlay[i] == OVERLAY_BOX) {
+                if (nboxes == SOKO_MAX_BOXES) return SOLVE_INVALID;
+                root_boxes[nboxes++] = c;  // 按下标升序
+            }
+            if (base[i] == BASE_TARGET) {
+                if (ngoals == SOKO_MAX_BOXES) return SOLVE_INVALID;
+                s->goals[ngoals++] = c;
+            }
+        }
+    }
+    if (player < 0 || nboxes == 0 || nboxes != ngoals) return SOLVE_INVALID;
+    s->nboxes = nboxes;
+
+    int cells = s->cells;
+    s->wall = solver_alloc(s, cells);
+    s->dead = solver_alloc(s, cells);
+    s->dist = solver_alloc(s, (size_t)nboxes * cells * sizeof(uint16_t));
+    s->zbox = solver_alloc(s, cells * sizeof(uint64_t));
+    s->zplayer = solver_alloc(s, cells * sizeof(uint64_t));
+    s->occ = solver_alloc(s, cells);
+    s->mark = solver_alloc(s, cells * sizeof(uint32_t));
+    s->queue = solver_alloc(s, cells * sizeof(uint16_t));
+    s->from = solver_alloc(s, cells);
+    pad_walls(base, width, height, s->wall);
+
+    // 死格：没有任何目标能把箱子拉过来的格子
+    memset(s->dead, 1, cells);
+    for (int g = 0; g < nboxes; g++) {
+        uint16_t *dist = s->dist + g * cells;
+        pull_distances(s->wall, cells, s->off, s->goals[g], dist, s->queue);
+        for (int i = 0; i < cells; i++) {
+            if (dist[i] != INF_DIST) s->dead[i] = 0;
+        }
+    }
+
+    uint64_t seed = 0x50b0c0ffeeull;
+    for (int i = 0; i < cells; i++) {
+        s->zbox[i] = next_random(&seed);
+        s->zplayer[i] = next_random(&seed);
+    }
+
+    // 根节点
+    s->cap = 1024;
+    s->boxes = solver_alloc(s, (size_t)s->cap * nboxes * 2);
+    s->hash = solver_alloc(s, s->cap * sizeof(uint64_t));
+    s->parent = solver_alloc(s, s->cap * sizeof(int32_t));
+    s->player = solver_alloc(s, s->cap * 2);
+    s->g = solver_alloc(s, s->cap * 2);
+    s->h = solver_alloc(s, s->cap * 2);
+    s->push = solver_alloc(s, s->cap * 2);
+    s->mask = 2048 - 1;
+    s->table = solver_alloc(s, (s->mask + 1) * sizeof(int32_t));
+    memset(s->table, 0xff, (s->mask + 1) * sizeof(int32_t));
+
+    SolveResult result = SOLVE_NONE;
+    int bound = lower_bound(s, root_boxes);
+    if (bound >= INF_COST) goto done;
+
+    int root = new_node(s);
+    memcpy(s->boxes, root_boxes, nboxes * sizeof(uint16_t));
+    for (int i = 0; i < nboxes; i++) {
+        s->occ[root_boxes[i]] = 1;
+        s->hash[root] ^= s->zbox[root_boxes[i]];
+    }
+    s->player[root] = reach(s, player);
+    s->hash[root] ^= s->zplayer[s->player[root]];
+    s->parent[root] = NO_NODE;
+    s->h[root] = bound;
+    table_insert(s, root);
+    open_push(s, root);
+    memset(s->occ, 0, cells);
+
+    uint16_t pushes[SOKO_MAX_BOXES * 4];
+    uint16_t child[SOKO_MAX_BOXES];
+    while (s->open_len > 0) {
+        OpenEntry e = open_pop(s);
+        int node = e.node;
+        if ((e.key >> 16) != (uint32_t)(s->g[node] + s->h[node])) continue;  // 已经以更小的代价重新加入过
+        if (s->h[node] == 0) {
+            stats->pushes = s->g[node];
+            stats->moves = write_solution(s, node, player, lurd, lurd_size);
+            result = SOLVE_OK;
+            goto done;
+        }
+        stats->expanded++;
+
+        // 先用当前节点的可达区域列出所有可行的推动
+        const uint16_t *boxes = s->boxes + node * nboxes;
+        for (int i = 0; i < nboxes; i++) {
+            s->occ[boxes[i]] = 1;
+        }
+        reach(s, s->player[node]);
+        int npushes = 0;
+        for (int i = 0; i < nboxes; i++) {
+            int b = boxes[i];
+            for (int d = 0; d < 4; d++) {
+                int t = b + s->off[d];
+                if (s->mark[b - s->off[d]] == s->stamp && !s->wall[t] && !s->occ[t] && !s->dead[t]) {
+                    pushes[npushes++] = i << 2 | d;
+                }
+            }
+        }
+
+        for (int k = 0; k < npushes; k++) {
+            boxes = s->boxes + node * nboxes;  // new_node 可能移动了数组
+            int i = pushes[k] >> 2, d = pushes[k] & 3;
+            int b = boxes[i], t = b + s->off[d];
+            stats->generated++;
+
+            // 推动后的箱子仍保持升序
+            memcpy(child, boxes, nboxes * sizeof(uint16_t));
+            int j = i;
+            for (; j > 0 && child[j - 1] > t; j--) {
+                child[j] = child[j - 1];
+            }
+            for (; j < nboxes - 1 && child[j + 1] < t; j++) {
+                child[j] = child[j + 1];
+            }
+            child[j] = t;
+
+            s->occ[b] = 0;
+            s->occ[t] = 1;
+            int norm = reach(s, b);
+            s->occ[t] = 0;
+            s->occ[b] = 1;
+
+            uint64_t hash = s->hash[node] ^ s->zbox[b] ^ s->zbox[t] ^ s->zplayer[s->player[node]] ^ s->zplayer[norm];
+            int g = s->g[node] + 1;
+            int found = table_find(s, hash, child, norm);
+            if (found != NO_NODE) {
+                if (s->g[found] <= g) continue;
+                s->g[found] = g;
+                s->parent[found] = node;
+                s->push[found] = b << 2 | d;
+                open_push(s, found);
+                continue;
+            }
+            int h = lower_bound(s, child);
+            if (h >= INF_COST) continue;
+            if (s->count >= s->max_nodes) {
+                result = SOLVE_LIMIT;
+                goto done;
+            }
+            int c = new_node(s);
+            memcpy(s->boxes + c * nboxes, child, nboxes * sizeof(uint16_t));
+            s->hash[c] = hash;
+            s->player[c] = norm;
+            s->parent[c] = node;
+            s->g[c] = g;
+            s->h[c] = h;
+            s->push[c] = b << 2 | d;
+            table_insert(s, c);
+            open_push(s, c);
+        }
+        boxes = s->boxes + node * nboxes;
+        for (int i = 0; i < nboxes; i++) {
+            s->occ[boxes[i]] = 0;
+        }
+    }
+
+done:
+    stats->memory = s->memory;
+    free_solver(s);
+    return result;
+}
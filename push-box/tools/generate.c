@@ -0,0 +1,313 @@
+// 主机端推箱子关卡生成器（反向推演）
+// 用法: generate [-n 关卡数] [-j 线程数] [-w 宽] [-h 高] [-b 箱子数] [-p 拉动次数]
+//                [-m 最少推动次数] [-s 种子] > levels.xsb
+// 每个候选关卡这样得到：随机生成房间（外墙 + 随机内墙，只保留最大的连通区域），
+// 把箱子放在目标点上作为已解局面，然后让玩家反过来随机“拉”箱子若干次。
+// 拉出来的局面一定有解；再用 ../solver.c 求出推动次数最少的解，
+// 按解的长度和搜索的平均分支数打分，推动次数不够的丢弃。
+// 去重用规范哈希：裁掉外围的墙，取8种旋转/翻转下哈希值最小的一个，玩家位置规范化为
+// 所在连通区域中下标最小的格子；所有线程共用一张无锁哈希表。
+// 输出 XSB（tools/xsb.h 与 BaseType/OverlayType 一一对应），放进 ../levels/ 就会打进游戏的关卡包。
+// 多线程时关卡的输出顺序不固定，-j 1 时由种子决定。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../sokoban.h"
+#include "../levelpack.h"
+#include "xsb.h"
+
+#define MAX_DIM LEVELPACK_MAX_DIM  // 生成的关卡要能打进关卡包
+#define SEEN_BITS 22              // 去重表 2^22 项
+#define SEEN_LIMIT (1u << (SEEN_BITS - 1))  // 装到一半就停止生成，线性探测在这之后会越来越慢
+#define MAX_SOLVE_NODES 50000     // 求解超过这么多节点的候选直接丢弃
+#define WALL_PERCENT 22           // 内墙比例
+
+static int width = 10, height = 10, nboxes = 4, pulls = 300, min_pushes = 12;
+static int target_count = 100;
+static uint64_t base_seed = 1;
+
+static uint64_t *seen;           // 规范哈希，0 为空
+static unsigned seen_count;      // 去重表已用的项数
+static int accepted;             // 已输出的关卡数
+static int seen_full;            // 去重表已满，所有线程停止
+static uint64_t candidates, duplicates, unsolved;
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const int dx[4] = { -1, 0, 1, 0 }, dy[4] = { 0, -1, 0, 1 };
+
+static uint64_t xorshift64(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+static int rand_below(uint64_t *s, int n) {
+    return (int)(xorshift64(s) % n);
+}
+
+// 从 start 出发沿 ok 为1的格子洪泛，把到达的格子标在 mark 里，返回格子数
+static int flood(const uint8_t *ok, int start, uint8_t *mark, int *queue) {
+    int head = 0, tail = 0;
+    memset(mark, 0, width * height);
+    mark[start] = 1;
+    queue[tail++] = start;
+    while (head < tail) {
+        int c = queue[head++], x = c % width, y = c / width;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + dx[d], ny = y + dy[d], n = ny * width + nx;
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height || !ok[n] || mark[n]) continue;
+            mark[n] = 1;
+            queue[tail++] = n;
+        }
+    }
+    return tail;
+}
+
+// 随机房间：外墙 + 随机内墙，只保留最大的连通地板区域
+static int make_room(XsbLevel *lv, uint64_t *rng) {
+    uint8_t floor[MAX_DIM * MAX_DIM], mark[MAX_DIM * MAX_DIM], best[MAX_DIM * MAX_DIM];
+    int queue[MAX_DIM * MAX_DIM], n = width * height, best_size = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int edge = x == 0 || y == 0 || x == width - 1 || y == height - 1;
+            floor[y * width + x] = !edge && rand_below(rng, 100) >= WALL_PERCENT;
+        }
+    }
+    uint8_t done[MAX_DIM * MAX_DIM] = { 0 };
+    for (int i = 0; i < n; i++) {
+        if (!floor[i] || done[i]) continue;
+        int size = flood(floor, i, mark, queue);
+        for (int j = 0; j < n; j++) {
+            done[j] |= mark[j];
+        }
+        if (size > best_size) {
+            best_size = size;
+            memcpy(best, mark, n);
+        }
+    }
+    lv->width = width;
+    lv->height = height;
+    for (int i = 0; i < n; i++) {
+        lv->base[i] = best_size && best[i] ? BASE_FLOOR : BASE_WALL;
+        lv->overlay[i] = OVERLAY_NONE;
+    }
+    return best_size;
+}
+
+// 反向推演：箱子都在目标点上，玩家随机站位，然后随机拉箱子。
+// 玩家站在箱子旁边 b+d，往外退到 b+2d，箱子跟着到 b+d；每次在玩家能走到的站位里随机选一个。
+static int reverse_play(XsbLevel *lv, uint64_t *rng) {
+    int n = width * height, floors[MAX_DIM * MAX_DIM], nfloors = 0;
+    for (int i = 0; i < n; i++) {
+        if (lv->base[i] != BASE_WALL) floors[nfloors++] = i;
+    }
+    if (nfloors < 2 * nboxes + 4) return 0;
+    // 随机挑 nboxes 个目标点和一个玩家位置（部分洗牌）
+    for (int k = 0; k <= nboxes; k++) {
+        int j = k + rand_below(rng, nfloors - k), t = floors[k];
+        floors[k] = floors[j];
+        floors[j] = t;
+    }
+    for (int k = 0; k < nboxes; k++) {
+        lv->base[floors[k]] = BASE_TARGET;
+        lv->overlay[floors[k]] = OVERLAY_BOX;
+    }
+    int player = floors[nboxes];
+
+    uint8_t free_cell[MAX_DIM * MAX_DIM], reach[MAX_DIM * MAX_DIM];
+    int queue[MAX_DIM * MAX_DIM], moves[MAX_DIM * MAX_DIM * 4];
+    int done = 0;
+    for (int step = 0; step < pulls; step++) {
+        for (int i = 0; i < n; i++) {
+            free_cell[i] = lv->base[i] != BASE_WALL && lv->overlay[i] != OVERLAY_BOX;
+        }
+        flood(free_cell, player, reach, queue);
+        int nmoves = 0;
+        for (int b = 0; b < n; b++) {
+            if (lv->overlay[b] != OVERLAY_BOX) continue;
+            int x = b % width, y = b / width;
+            for (int d = 0; d < 4; d++) {
+                int x1 = x + dx[d], y1 = y + dy[d], x2 = x1 + dx[d], y2 = y1 + dy[d];
+                if (x2 < 0 || y2 < 0 || x2 >= width || y2 >= height) continue;
+                if (reach[y1 * width + x1] && free_cell[y2 * width + x2]) moves[nmoves++] = b * 4 + d;
+            }
+        }
+        if (nmoves == 0) break;
+        int m = moves[rand_below(rng, nmoves)], b = m / 4, d = m % 4;
+        int p1 = b + dy[d] * width + dx[d];
+        lv->overlay[b] = OVERLAY_NONE;
+        lv->overlay[p1] = OVERLAY_BOX;
+        player = p1 + dy[d] * width + dx[d];
+        done++;
+    }
+    // 玩家在最后所在的区域里随便站一个位置
+    for (int i = 0; i < n; i++) {
+        free_cell[i] = lv->base[i] != BASE_WALL && lv->overlay[i] != OVERLAY_BOX;
+    }
+    int size = flood(free_cell, player, reach, queue);
+    player = queue[rand_below(rng, size)];
+    lv->overlay[player] = OVERLAY_PLAYER;
+    return done;
+}
+
+static uint64_t fnv1a(uint64_t h, uint8_t byte) {
+    return (h ^ byte) * 0x100000001b3ull;
+}
+
+// 规范哈希：去掉外围的墙，取8种对称变换下的最小值；玩家位置换成它所在区域里（变换后）下标最小的格子
+static uint64_t canonical_hash(const XsbLevel *lv) {
+    int n = lv->width * lv->height, x0 = lv->width, y0 = lv->height, x1 = -1, y1 = -1;
+    uint8_t free_cell[MAX_DIM * MAX_DIM], reach[MAX_DIM * MAX_DIM];
+    int queue[MAX_DIM * MAX_DIM], player = 0;
+    for (int i = 0; i < n; i++) {
+        int x = i % lv->width, y = i / lv->width;
+        free_cell[i] = lv->base[i] != BASE_WALL && lv->overlay[i] != OVERLAY_BOX;
+        if (lv->overlay[i] == OVERLAY_PLAYER) player = i;
+        if (lv->base[i] == BASE_WALL) continue;
+        if (x < x0) x0 = x;
+        if (x > x1) x1 = x;
+        if (y < y0) y0 = y;
+        if (y > y1) y1 = y;
+    }
+    flood(free_cell, player, reach, queue);
+    int w = x1 - x0 + 1, h = y1 - y0 + 1;
+    uint64_t best = UINT64_MAX;
+    for (int t = 0; t < 8; t++) {
+        int tw = t & 4 ? h : w, th = t & 4 ? w : h;
+        uint64_t hash = fnv1a(fnv1a(0xcbf29ce484222325ull, tw), th);
+        int player_done = 0;
+        for (int ty = 0; ty < th; ty++) {
+            for (int tx = 0; tx < tw; tx++) {
+                // 变换后的 (tx,ty) 对应原图 (sx,sy)：t&4 转置，t&1 左右翻，t&2 上下翻
+                int ux = t & 1 ? tw - 1 - tx : tx, uy = t & 2 ? th - 1 - ty : ty;
+                int sx = t & 4 ? uy : ux, sy = t & 4 ? ux : uy;
+                int i = (sy + y0) * lv->width + sx + x0;
+                int overlay = lv->overlay[i] == OVERLAY_BOX ? OVERLAY_BOX : OVERLAY_NONE;
+                if (reach[i] && !player_done) {
+                    overlay = OVERLAY_PLAYER;
+                    player_done = 1;
+                }
+                hash = fnv1a(hash, lv->base[i] | overlay << 2);
+            }
+        }
+        if (hash < best) best = hash;
+    }
+    return best ? best : 1;
+}
+
+// 加入去重表，已经有了返回0，表已装到 SEEN_LIMIT 返回-1。
+// 各线程先查计数再插入，最多多插线程数那么几项，离装满还远
+static int mark_seen(uint64_t hash) {
+    uint64_t mask = (1ull << SEEN_BITS) - 1;
+    for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+        uint64_t cur = __atomic_load_n(&seen[i], __ATOMIC_RELAXED);
+        if (cur == hash) return 0;
+        if (cur == 0) {
+            if (__atomic_load_n(&seen_count, __ATOMIC_RELAXED) >= SEEN_LIMIT) return -1;
+            uint64_t expected = 0;
+            if (__atomic_compare_exchange_n(&seen[i], &expected, hash, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                __atomic_fetch_add(&seen_count, 1, __ATOMIC_RELAXED);
+                return 1;
+            }
+            if (expected == hash) return 0;
+        }
+    }
+}
+
+static void print_level(const XsbLevel *lv, int id, const SolveStats *st, double branching, int score) {
+    printf("; %d  pushes %d moves %d branching %.2f score %d\n", id, st->pushes, st->moves, branching, score);
+    xsb_write(stdout, lv);
+    printf("\n");
+}
+
+static void *worker(void *arg) {
+    uint64_t rng = base_seed * 0x9e3779b97f4a7c15ull + (uintptr_t)arg * 0x632be59bd9b4e019ull + 1;
+    XsbLevel lv;
+    char lurd[4096];
+    while (__atomic_load_n(&accepted, __ATOMIC_RELAXED) < target_count &&
+           !__atomic_load_n(&seen_full, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&candidates, 1, __ATOMIC_RELAXED);
+        if (make_room(&lv, &rng) == 0 || reverse_play(&lv, &rng) == 0) continue;
+        int fresh = mark_seen(canonical_hash(&lv));
+        if (fresh < 0) {
+            __atomic_store_n(&seen_full, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        if (!fresh) {
+            __atomic_fetch_add(&duplicates, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        SolveStats st;
+        if (sokoban_solve(lv.base, lv.overlay, lv.width, lv.height, MAX_SOLVE_NODES, lurd, sizeof(lurd), &st) !=
+            SOLVE_OK) {
+            __atomic_fetch_add(&unsolved, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (st.pushes < min_pushes) continue;
+        // 分数：推动次数乘以平均分支数（每展开一个节点生成的子节点数）
+        double branching = st.expanded ? (double)st.generated / st.expanded : 1.0;
+        int score = (int)(st.pushes * branching);
+        pthread_mutex_lock(&out_lock);
+        if (accepted < target_count) {
+            print_level(&lv, accepted + 1, &st, branching, score);
+            accepted++;
+        }
+        pthread_mutex_unlock(&out_lock);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int threads = sysconf(_SC_NPROCESSORS_ONLN), opt;
+    while ((opt = getopt(argc, argv, "n:j:w:h:b:p:m:s:")) != -1) {
+        switch (opt) {
+            case 'n': target_count = atoi(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'w': width = atoi(optarg); break;
+            case 'h': height = atoi(optarg); break;
+            case 'b': nboxes = atoi(optarg); break;
+            case 'p': pulls = atoi(optarg); break;
+            case 'm': min_pushes = atoi(optarg); break;
+            case 's': base_seed = strtoull(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n levels] [-j threads] [-w width] [-h height] [-b boxes] "
+                                "[-p pulls] [-m min_pushes] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (width < 4 || height < 4 || width > MAX_DIM || height > MAX_DIM || nboxes < 1 || nboxes > SOKO_MAX_BOXES ||
+        threads < 1) {
+        fprintf(stderr, "bad parameters\n");
+        return 2;
+    }
+    seen = calloc(1ull << SEEN_BITS, sizeof(uint64_t));
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_t tids[threads];
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&tids[i], NULL, worker, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    fprintf(stderr, "%d levels from %llu candidates in %.2f s (%.0f candidates/s on %d threads), "
+                    "%llu duplicates, %llu unsolved within %d nodes\n",
+            accepted, (unsigned long long)candidates, sec, candidates / sec, threads,
+            (unsigned long long)duplicates, (unsigned long long)unsolved, MAX_SOLVE_NODES);
+    free(seen);
+    if (seen_full) {
+        fprintf(stderr, "stopped early: %u distinct candidates fill half of the 2^%d dedup table\n",
+                seen_count, SEEN_BITS);
+        return 1;
+    }
+    return 0;
+}
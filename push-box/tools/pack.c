@@ -0,0 +1,122 @@
+// 主机端关卡打包工具
+// 用法: pack [-c] -o 输出文件 关卡文件.xsb ...
+// 按顺序读入所有 XSB 文件里的关卡，打包成 ../levelpack.h 描述的格式；
+// -c 输出 C 源文件（定义 levelpack_builtin），构建游戏时由 Makefile 调用生成 levels.c。
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../levelpack.h"
+#include "xsb.h"
+
+#define MAX_PACK (1 << 20)
+
+static uint8_t pack[MAX_PACK];
+static uint32_t offsets[65535];
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// 把 files 里的关卡依次追加到 pack，返回打包后的总字节数，出错返回 0
+static size_t build_pack(char **files, int nfiles, int *count) {
+    static XsbLevel lv;
+    size_t cells_size = 0;
+    int n = 0;
+    for (int f = 0; f < nfiles; f++) {
+        FILE *fp = fopen(files[f], "r");
+        if (!fp) {
+            perror(files[f]);
+            return 0;
+        }
+        int r;
+        for (int k = 1; (r = xsb_read(fp, &lv)) != 0; k++) {
+            if (r < 0 || lv.width > LEVELPACK_MAX_DIM || lv.height > LEVELPACK_MAX_DIM) {
+                fprintf(stderr, "%s #%d: too large, skipped\n", files[f], k);
+                continue;
+            }
+            int bytes = 2 + (lv.width * lv.height + 1) / 2;
+            if (n == 65535 || cells_size + bytes > MAX_PACK / 2) {
+                fprintf(stderr, "too many levels\n");
+                fclose(fp);
+                return 0;
+            }
+            // 关卡数据先放在 pack 后半部分，偏移表的大小确定后再挪到前面
+            uint8_t *p = pack + MAX_PACK / 2 + cells_size;
+            memset(p, 0, bytes);
+            p[0] = lv.width;
+            p[1] = lv.height;
+            for (int i = 0; i < lv.width * lv.height; i++) {
+                p[2 + i / 2] |= (lv.base[i] | lv.overlay[i] << 2) << (i % 2 * 4);
+            }
+            // 编码后按游戏载入时的规则检查，不合法的不计入
+            const char *err = levelpack_check(p);
+            if (err) {
+                fprintf(stderr, "%s #%d: %s, skipped\n", files[f], k, err);
+                continue;
+            }
+            offsets[n++] = cells_size;
+            cells_size += bytes;
+        }
+        fclose(fp);
+    }
+    size_t head = sizeof(levelpack_header_t) + n * sizeof(uint32_t);
+    put_u32(pack, LEVELPACK_MAGIC);
+    pack[4] = LEVELPACK_VERSION;
+    pack[5] = LEVELPACK_VERSION >> 8;
+    pack[6] = n;
+    pack[7] = n >> 8;
+    for (int i = 0; i < n; i++) {
+        put_u32(pack + sizeof(levelpack_header_t) + i * sizeof(uint32_t), head + offsets[i]);
+    }
+    memmove(pack + head, pack + MAX_PACK / 2, cells_size);
+    *count = n;
+    return head + cells_size;
+}
+
+static void write_c(FILE *out, size_t size, int count) {
+    fprintf(out, "// 由 tools/pack 生成，不要手改：%d 个关卡，%zu 字节\n", count, size);
+    fprintf(out, "#include \"levelpack.h\"\n\n");
+    fprintf(out, "const uint8_t levelpack_builtin[] = {");
+    for (size_t i = 0; i < size; i++) {
+        fprintf(out, "%s0x%02x,", i % 16 ? " " : "\n    ", pack[i]);
+    }
+    fprintf(out, "\n};\n\nconst uint32_t levelpack_builtin_size = %zu;\n", size);
+}
+
+int main(int argc, char **argv) {
+    const char *output = NULL;
+    int c_source = 0, opt;
+    while ((opt = getopt(argc, argv, "co:")) != -1) {
+        switch (opt) {
+            case 'c': c_source = 1; break;
+            case 'o': output = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-c] -o output level.xsb ...\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!output || optind == argc) {
+        fprintf(stderr, "usage: %s [-c] -o output level.xsb ...\n", argv[0]);
+        return 2;
+    }
+    int count = 0;
+    size_t size = build_pack(argv + optind, argc - optind, &count);
+    if (size == 0 || count == 0) return 1;
+    FILE *out = fopen(output, c_source ? "w" : "wb");
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    if (c_source) {
+        write_c(out, size, count);
+    } else {
+        fwrite(pack, 1, size, out);
+    }
+    fclose(out);
+    fprintf(stderr, "%s: %d levels, %zu bytes\n", output, count, size);
+    return 0;
+}
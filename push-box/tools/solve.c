@@ -0,0 +1,72 @@
+// 主机端推箱子求解器
+// 用法: solve [-n 节点上限] [-q] [关卡文件.xsb ...]
+// 依次求解文件（默认标准输入）里的每个关卡，输出推动次数最优的解（LURD 格式，-q 不输出解）、
+// 展开的节点数、每秒节点数和内存占用。求解器与游戏里按 H 提示用的是同一份 ../solver.c。
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "../sokoban.h"
+#include "xsb.h"
+
+#define MAX_LURD 65536
+
+static const char *result_names[] = { "solved", "no solution", "node limit", "invalid" };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 求解一个文件里的所有关卡，返回未解出的关卡数
+static int solve_file(FILE *f, const char *name, int max_nodes, int quiet) {
+    static XsbLevel level;
+    static char lurd[MAX_LURD];
+    int failed = 0, r;
+    for (int k = 1; (r = xsb_read(f, &level)) != 0; k++) {
+        if (r < 0) {
+            printf("%s #%d: level too large\n", name, k);
+            failed++;
+            continue;
+        }
+        SolveStats st;
+        double t0 = now_sec();
+        SolveResult res = sokoban_solve(level.base, level.overlay, level.width, level.height, max_nodes,
+                                        lurd, sizeof(lurd), &st);
+        double sec = now_sec() - t0;
+        printf("%s #%d%s%s: %s", name, k, level.title[0] ? " " : "", level.title, result_names[res]);
+        if (res == SOLVE_OK) printf(", %d pushes, %d moves", st.pushes, st.moves);
+        printf("\n  %llu nodes expanded, %llu generated, %.1f ms, %.0f nodes/s, %zu KB\n",
+               (unsigned long long)st.expanded, (unsigned long long)st.generated, sec * 1000,
+               sec > 0 ? st.generated / sec : 0.0, st.memory / 1024);
+        if (res == SOLVE_OK && !quiet) printf("  %s\n", lurd);
+        failed += res != SOLVE_OK;
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    int max_nodes = 4000000, quiet = 0, opt;
+    while ((opt = getopt(argc, argv, "n:q")) != -1) {
+        switch (opt) {
+            case 'n': max_nodes = atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n max_nodes] [-q] [level.xsb ...]\n", argv[0]);
+                return 2;
+        }
+    }
+    int failed = 0;
+    if (optind == argc) return solve_file(stdin, "stdin", max_nodes, quiet) != 0;
+    for (int i = optind; i < argc; i++) {
+        FILE *f = fopen(argv[i], "r");
+        if (!f) {
+            perror(argv[i]);
+            return 2;
+        }
+        failed += solve_file(f, argv[i], max_nodes, quiet);
+        fclose(f);
+    }
+    return failed != 0;
+}
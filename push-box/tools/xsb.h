@@ -0,0 +1,89 @@
+#ifndef PUSH_BOX_XSB_H__
+#define PUSH_BOX_XSB_H__
+
+// 主机端工具读写 XSB 格式的关卡：
+//   # 墙  空格/-/_ 地板  . 目标点  $ 箱子  * 目标点上的箱子  @ 玩家  + 目标点上的玩家
+// 以 ; 开头的行是注释，关卡前最后一行注释作为关卡名；关卡之间用空行或注释隔开。
+
+#include <stdio.h>
+#include <string.h>
+#include "../sokoban.h"
+
+typedef struct {
+    int width, height;
+    BaseType base[SOKO_MAX_CELLS];
+    OverlayType overlay[SOKO_MAX_CELLS];
+    char title[64];
+} XsbLevel;
+
+static inline int xsb_is_map_line(const char *line) {
+    int walls = 0;
+    for (const char *p = line; *p && *p != '\n' && *p != '\r'; p++) {
+        if (!strchr(" -_#.$*@+", *p)) return 0;
+        walls += *p == '#';
+    }
+    return walls > 0;
+}
+
+// 读下一个关卡，成功返回1，文件结束返回0，关卡太大返回-1
+static inline int xsb_read(FILE *f, XsbLevel *level) {
+    char line[256], rows[64][256];
+    int nrows = 0;
+    level->title[0] = '\0';
+    while (fgets(line, sizeof(line), f)) {
+        if (xsb_is_map_line(line)) {
+            if (nrows == 64) return -1;
+            strcpy(rows[nrows++], line);
+            continue;
+        }
+        if (nrows > 0) break;
+        if (line[0] == ';') {
+            int n = strcspn(line + 1, "\r\n");
+            const char *t = line + 1 + strspn(line + 1, " ");
+            n -= t - (line + 1);
+            snprintf(level->title, sizeof(level->title), "%.*s", n > 0 ? n : 0, t);
+        }
+    }
+    if (nrows == 0) return 0;
+
+    int width = 0;
+    for (int y = 0; y < nrows; y++) {
+        int n = strcspn(rows[y], "\r\n");
+        if (n > width) width = n;
+    }
+    if ((width + 2) * (nrows + 2) > SOKO_MAX_CELLS) return -1;
+    level->width = width;
+    level->height = nrows;
+    for (int y = 0; y < nrows; y++) {
+        int n = strcspn(rows[y], "\r\n");
+        for (int x = 0; x < width; x++) {
+            char c = x < n ? rows[y][x] : ' ';
+            int i = y * width + x;
+            level->base[i] = c == '#' ? BASE_WALL : strchr(".*+", c) ? BASE_TARGET : BASE_FLOOR;
+            level->overlay[i] = strchr("$*", c) ? OVERLAY_BOX : strchr("@+", c) ? OVERLAY_PLAYER : OVERLAY_NONE;
+        }
+    }
+    return 1;
+}
+
+// 写出一个关卡（不含关卡名），每行末尾的空地板省略
+static inline void xsb_write(FILE *f, const XsbLevel *level) {
+    static const char chars[3][3] = {
+        // OVERLAY_NONE/BOX/PLAYER
+        { ' ', '$', '@' },  // BASE_FLOOR
+        { '#', '#', '#' },  // BASE_WALL
+        { '.', '*', '+' },  // BASE_TARGET
+    };
+    char row[256];
+    for (int y = 0; y < level->height; y++) {
+        int n = 0;
+        for (int x = 0; x < level->width; x++) {
+            int i = y * level->width + x;
+            row[n++] = chars[level->base[i]][level->overlay[i]];
+        }
+        while (n > 0 && row[n - 1] == ' ') n--;
+        fprintf(f, "%.*s\n", n, row);
+    }
+}
+
+#endif